@@ -24,6 +24,7 @@ meta:
 common:
 	# dependencies with other addons, a list of them separated by spaces 
 	# or use += in several lines
+	# ofxNetwork is optional: add it to a project to get SomPaletteStreamSender/Receiver
 	ADDON_DEPENDENCIES = ofxSelfOrganizingMap
 	
 	# include search paths, this will be usually parsed from the file system
@@ -87,13 +88,17 @@ linux64:
 	# linux only, any library that should be included in the project using
 	# pkg-config
 	# ADDON_PKG_CONFIG_LIBRARIES =
+	# shm_open for SomPaletteSharedMemoryPublisher/Reader (older glibc)
+	ADDON_LDFLAGS += -lrt
 vs:
 	# After compiling copy the following dynamic libraries to the executable directory
 	# only windows visual studio
 	# ADDON_DLLS_TO_COPY = 
 	
 linuxarmv6l:
+	ADDON_LDFLAGS += -lrt
 linuxarmv7l:
+	ADDON_LDFLAGS += -lrt
 android/armeabi:	
 android/armeabi-v7a:	
 osx:
@@ -0,0 +1,6 @@
+#include "ofApp.h"
+
+int main(){
+  ofSetupOpenGL(1024, 512, OF_WINDOW);
+  ofRunApp(new ofApp());
+}
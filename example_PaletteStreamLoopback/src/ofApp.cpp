@@ -0,0 +1,90 @@
+#include "ofApp.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// A delta carries each sample to within half its step (64 of 65535 at the default shift), plus
+// the 16-bit rounding of the source.
+constexpr float deltaTolerance = 32.5f / 65535.0f + 1e-6f;
+
+} // namespace
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+  ofSetFrameRate(60);
+  sender = std::make_shared<SomPaletteStreamSender>("127.0.0.1", port);
+  somPalette.addSink(sender);
+  somPalette.setVisible(true);
+  nextReportMicros = ofGetElapsedTimeMicros() + 1000000;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+  batch.clear();
+  generator.generate(ofGetElapsedTimef(), batch);
+  for (const auto& instance : batch) {
+    somPalette.addInstanceData(instance);
+  }
+
+  // Publishing sends the snapshot; on loopback it is already waiting when the receiver updates.
+  somPalette.update();
+  receiver.update();
+  if (somPalette.hasNewPixels() && receiver.isNewFrameReady()) compare();
+
+  if (ofGetElapsedTimeMicros() >= nextReportMicros) {
+    report();
+    nextReportMicros += 1000000;
+  }
+}
+
+void ofApp::compare() {
+  const ofFloatPixels& sent = somPalette.getPixelsRef();
+  const ofFloatPixels& received = receiver.getPixelsRef();
+  if (sent.getWidth() != received.getWidth() || sent.getHeight() != received.getHeight()) return;
+
+  const float* a = sent.getData();
+  const float* b = received.getData();
+  float frameError = 0.0f;
+  for (size_t i = 0; i < sent.size(); ++i) {
+    frameError = std::max(frameError, std::abs(a[i] - b[i]));
+  }
+  maxError = std::max(maxError, frameError);
+  ++framesCompared;
+  if (frameError > deltaTolerance) ++framesCatchingUp;
+}
+
+void ofApp::report() {
+  ofLogNotice("PaletteStreamLoopback") << framesCompared << " frames compared, max error " << ofToString(maxError * 65535.0f, 1) << "/65535"
+                                       << ", " << framesCatchingUp << " still catching up on large changes"
+                                       << "; " << sender->getBytesSent() << " bytes sent, "
+                                       << receiver.getPacketsLost() << " packets lost, "
+                                       << receiver.getFramesDropped() << " frames dropped";
+  maxError = 0.0f;
+  framesCompared = 0;
+  framesCatchingUp = 0;
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+  ofBackground(0);
+  const float size = std::min(ofGetWidth() * 0.5f, static_cast<float>(ofGetHeight()));
+
+  ofPushMatrix();
+  ofScale(size, size);
+  somPalette.draw();
+  ofPopMatrix();
+
+  ofPushMatrix();
+  ofTranslate(size, 0);
+  ofScale(size, size);
+  receiver.draw();
+  ofPopMatrix();
+}
+
+//--------------------------------------------------------------
+void ofApp::keyPressed(int key){
+  if (key == 'k') sender->requestKeyframe();
+  else somPalette.keyPressed(key);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+
+#include "ofMain.h"
+#include "ofxSomPalette.h"
+#include "ofxSomInstanceGenerator.h"
+#include "ofxSomPaletteStreamSender.h"
+#include "ofxSomPaletteStreamReceiver.h"
+
+// Streams a SomPalette to a SomPaletteStreamReceiver in the same app over 127.0.0.1 and checks the
+// reconstruction against the original every frame. Left: the palette, right: what was received.
+class ofApp: public ofBaseApp{
+public:
+  void setup();
+  void update();
+  void draw();
+  void keyPressed(int key);
+
+private:
+  static constexpr unsigned short port = 9100;
+
+  SomPalette somPalette { 16, 16, 0.01f, 100000 };
+  SomInstanceGenerator generator { SomInstanceGenerator::Mode::Cycle, 200.0 };
+  std::vector<SomInstanceDataT> batch;
+  std::shared_ptr<SomPaletteStreamSender> sender;
+  SomPaletteStreamReceiver receiver { port };
+
+  // Current report window
+  float maxError { 0.0f };
+  int framesCompared { 0 };
+  int framesCatchingUp { 0 }; // large changes still being spread over several deltas
+  uint64_t nextReportMicros { 0 };
+
+  void compare();
+  void report();
+};
@@ -0,0 +1,254 @@
+#include "PaletteTimelineRenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace {
+
+// ofSaveImage (FreeImage) isn't safe to call from several threads at once. Saving a strip is
+// quick next to training, so workers take turns.
+std::mutex saveImageMutex;
+
+bool parseDouble(const std::string& s, double& valueOut) {
+  const char* begin = s.c_str();
+  char* end = nullptr;
+  valueOut = std::strtod(begin, &end);
+  if (end == begin) return false;
+  while (*end == ' ' || *end == '\t' || *end == '\r') ++end;
+  return *end == '\0';
+}
+
+SomInstanceDataT makeInstance(double f0, double f1, double f2) {
+  return { ofClamp(f0, 0.0, 1.0), ofClamp(f1, 0.0, 1.0), ofClamp(f2, 0.0, 1.0) };
+}
+
+std::string toHex(const ofColor& c) {
+  char hex[8];
+  std::snprintf(hex, sizeof(hex), "#%02x%02x%02x", c.r, c.g, c.b);
+  return hex;
+}
+
+} // namespace
+
+int PaletteTimelineRenderer::run() {
+  const std::vector<InputFile> files = listInputFiles();
+  if (files.empty()) {
+    ofLogError("PaletteTimelineRenderer") << "no .csv or .f32 inputs found";
+    return 1;
+  }
+  ofDirectory::createDirectory(config.outputDirectory, false, true);
+
+  int numThreads = config.numThreads > 0 ? config.numThreads : static_cast<int>(std::thread::hardware_concurrency());
+  numThreads = std::max(1, std::min(numThreads, static_cast<int>(files.size())));
+
+  ofLogNotice("PaletteTimelineRenderer") << files.size() << " files on " << numThreads << " threads, "
+                                         << config.timeline.width << "x" << config.timeline.height << " "
+                                         << getSomBackendName(config.timeline.backend) << ", " << config.frameRate
+                                         << " fps -> " << config.outputDirectory;
+
+  // Files are independent, so each thread just takes the next one until none are left.
+  std::atomic<size_t> nextFile { 0 };
+  std::atomic<int> failures { 0 };
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&] {
+      for (size_t i = nextFile.fetch_add(1); i < files.size(); i = nextFile.fetch_add(1)) {
+        if (!render(files[i])) failures.fetch_add(1);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  ofLogNotice("PaletteTimelineRenderer") << "done in " << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / 1000.0
+                                         << " s, " << failures.load() << " failed";
+  return failures.load();
+}
+
+std::vector<PaletteTimelineRenderer::InputFile> PaletteTimelineRenderer::listInputFiles() const {
+  std::vector<InputFile> files;
+  for (const auto& input : config.inputs) {
+    if (ofDirectory::doesDirectoryExist(input, false)) {
+      ofDirectory dir(input);
+      dir.allowExt("csv");
+      dir.allowExt("f32");
+      dir.listDir();
+      dir.sort();
+      for (size_t i = 0; i < dir.size(); ++i) {
+        files.push_back({ dir.getPath(i), ofFilePath::getBaseName(dir.getPath(i)) });
+      }
+    } else {
+      files.push_back({ input, ofFilePath::getBaseName(input) });
+    }
+  }
+
+  // Output names must be unique or threads would overwrite each other's files: first tell
+  // same-named inputs apart by extension, then number whatever still collides.
+  std::map<std::string, int> counts;
+  for (const auto& file : files) ++counts[file.name];
+  for (auto& file : files) {
+    if (counts[file.name] > 1) file.name += "-" + ofToLower(ofFilePath::getFileExt(file.path));
+  }
+  std::set<std::string> taken;
+  for (auto& file : files) {
+    std::string name = file.name;
+    for (int n = 2; !taken.insert(name).second; ++n) name = file.name + "-" + ofToString(n);
+    if (name != ofFilePath::getBaseName(file.path)) {
+      ofLogNotice("PaletteTimelineRenderer") << file.path << " -> " << name << "-*";
+    }
+    file.name = name;
+  }
+  return files;
+}
+
+bool PaletteTimelineRenderer::loadFeatures(const std::string& path, FeatureStream& streamOut) const {
+  const std::string ext = ofToLower(ofFilePath::getFileExt(path));
+  if (ext == "csv") return loadCsv(path, streamOut);
+  if (ext == "f32") return loadFloat32(path, streamOut);
+  ofLogError("PaletteTimelineRenderer") << path << ": unknown extension (want .csv or .f32)";
+  return false;
+}
+
+bool PaletteTimelineRenderer::loadCsv(const std::string& path, FeatureStream& streamOut) const {
+  std::ifstream in(path);
+  if (!in) {
+    ofLogError("PaletteTimelineRenderer") << "can't open " << path;
+    return false;
+  }
+
+  std::string line;
+  std::vector<double> values;
+  while (std::getline(in, line)) {
+    const std::vector<std::string> fields = ofSplitString(line, ",", true, true);
+    if (fields.size() != 3 && fields.size() != 4) continue;
+
+    values.resize(fields.size());
+    bool ok = true;
+    for (size_t i = 0; i < fields.size() && ok; ++i) ok = parseDouble(fields[i], values[i]);
+    if (!ok) continue;
+
+    if (values.size() == 4) {
+      streamOut.seconds.push_back(values[0]);
+      streamOut.instances.push_back(makeInstance(values[1], values[2], values[3]));
+    } else {
+      streamOut.seconds.push_back(static_cast<double>(streamOut.instances.size()) / config.ratePerSecond);
+      streamOut.instances.push_back(makeInstance(values[0], values[1], values[2]));
+    }
+  }
+  return true;
+}
+
+bool PaletteTimelineRenderer::loadFloat32(const std::string& path, FeatureStream& streamOut) const {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    ofLogError("PaletteTimelineRenderer") << "can't open " << path;
+    return false;
+  }
+  const std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  constexpr size_t instanceBytes = 3 * sizeof(float);
+  if (bytes.size() % instanceBytes != 0) {
+    ofLogWarning("PaletteTimelineRenderer") << path << ": " << bytes.size() % instanceBytes << " trailing bytes ignored";
+  }
+
+  const size_t count = bytes.size() / instanceBytes;
+  streamOut.instances.reserve(count);
+  streamOut.seconds.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    float f[3];
+    std::memcpy(f, bytes.data() + i * instanceBytes, instanceBytes); // assumes a little-endian host
+    streamOut.seconds.push_back(static_cast<double>(i) / config.ratePerSecond);
+    streamOut.instances.push_back(makeInstance(f[0], f[1], f[2]));
+  }
+  return true;
+}
+
+bool PaletteTimelineRenderer::render(const InputFile& file) const {
+  const std::string& path = file.path;
+  FeatureStream stream;
+  if (!loadFeatures(path, stream)) return false;
+  if (stream.instances.empty()) {
+    ofLogWarning("PaletteTimelineRenderer") << path << ": no instances";
+    return false;
+  }
+
+  const std::string csvPath = ofFilePath::join(config.outputDirectory, file.name + "-palettes.csv");
+  const std::string stripPath = ofFilePath::join(config.outputDirectory, file.name + "-strip.png");
+
+  std::ofstream csv(csvPath);
+  if (!csv) {
+    ofLogError("PaletteTimelineRenderer") << "can't write " << csvPath;
+    return false;
+  }
+  csv << "frame,seconds";
+  for (size_t i = 0; i < SomPalette::size; ++i) csv << ",color" << i;
+  csv << "\n";
+
+  // Timestamps may be unsorted in hand-made CSVs; each instance lands in the frame it falls in.
+  std::vector<size_t> order(stream.instances.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return stream.seconds[a] < stream.seconds[b]; });
+  auto frameOf = [&](size_t i) { return static_cast<int64_t>(std::floor(stream.seconds[i] * config.frameRate)); };
+  const int64_t numFrames = std::max<int64_t>(0, frameOf(order.back())) + 1;
+
+  SomPaletteTimeline timeline(config.timeline);
+  SomPaletteColorsT palette;
+  std::vector<SomPaletteColorsT> stripRows;
+  const int stripEvery = std::max(1, config.stripEveryFrames);
+
+  size_t next = 0;
+  for (int64_t frame = 0; frame < numFrames; ++frame) {
+    while (next < order.size() && frameOf(order[next]) <= frame) {
+      timeline.addInstanceData(stream.instances[order[next]]);
+      ++next;
+    }
+    timeline.advanceFrame();
+    timeline.getPalette(palette);
+
+    csv << frame << "," << frame / config.frameRate;
+    for (const auto& c : palette) csv << "," << toHex(c);
+    csv << "\n";
+
+    if (frame % stripEvery == 0) stripRows.push_back(palette);
+  }
+
+  // Rows of chips separated by white gaps, oldest at the top.
+  const int chip = std::max(1, config.chipSize);
+  const int gap = std::max(1, chip / 8);
+  ofPixels strip;
+  strip.allocate(palette.size() * chip, stripRows.size() * (chip + gap), OF_IMAGE_COLOR);
+  strip.setColor(ofColor::white);
+  for (size_t row = 0; row < stripRows.size(); ++row) {
+    for (size_t i = 0; i < palette.size(); ++i) {
+      for (int y = 0; y < chip; ++y) {
+        for (int x = 0; x < chip; ++x) {
+          strip.setColor(i * chip + x, row * (chip + gap) + y, stripRows[row][i]);
+        }
+      }
+    }
+  }
+  bool isSaved;
+  {
+    std::lock_guard<std::mutex> lock(saveImageMutex);
+    isSaved = ofSaveImage(strip, stripPath);
+  }
+  if (!isSaved) {
+    ofLogError("PaletteTimelineRenderer") << "can't write " << stripPath;
+    return false;
+  }
+
+  ofLogNotice("PaletteTimelineRenderer") << file.name << ": " << stream.instances.size() << " instances, " << numFrames
+                                         << " frames, " << timeline.getHopCount() << " hops";
+  return true;
+}
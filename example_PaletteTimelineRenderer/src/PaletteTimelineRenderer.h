@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ofMain.h"
+#include "ofxSomPaletteTimeline.h"
+
+// Headless batch renderer: trains a ContinuousSomPalette-equivalent timeline (SomPaletteTimeline)
+// over recorded feature streams, one file per thread, as fast as the cores allow, and writes each
+// file's per-frame palettes (CSV) and a palette-strip image (PNG), named after the input file.
+// Inputs sharing a base name (e.g. take.csv and take.f32, or the same file name in two
+// directories) get their extension and then a counter appended, so no output is overwritten.
+//
+// Inputs are files or directories of:
+//   .csv  one instance per line: "f0,f1,f2" spaced at ratePerSecond, or "seconds,f0,f1,f2".
+//         Lines that don't parse (e.g. a header) are skipped.
+//   .f32  raw little-endian float32 triples spaced at ratePerSecond.
+// Features should already be normalised to 0..1; values outside are clamped.
+struct TimelineRenderConfig {
+  std::vector<std::string> inputs;
+  std::string outputDirectory { "." };
+  float frameRate { 30.0f };
+  double ratePerSecond { 100.0 }; // for inputs without timestamps
+  int stripEveryFrames { 30 }; // one palette row in the strip image per this many frames
+  int chipSize { 16 }; // strip image pixels per palette chip
+  int numThreads { 0 }; // 0: one per core
+  SomPaletteTimelineSettings timeline;
+};
+
+class PaletteTimelineRenderer {
+public:
+  explicit PaletteTimelineRenderer(const TimelineRenderConfig& config_) : config { config_ } {}
+
+  // Renders every input. Returns the number of files that failed.
+  int run();
+
+private:
+  struct InputFile {
+    std::string path;
+    std::string name; // output file prefix, unique across the run
+  };
+  struct FeatureStream {
+    std::vector<SomInstanceDataT> instances;
+    std::vector<double> seconds; // per instance
+  };
+
+  TimelineRenderConfig config;
+
+  std::vector<InputFile> listInputFiles() const;
+  bool render(const InputFile& file) const;
+  bool loadFeatures(const std::string& path, FeatureStream& streamOut) const;
+  bool loadCsv(const std::string& path, FeatureStream& streamOut) const;
+  bool loadFloat32(const std::string& path, FeatureStream& streamOut) const;
+};
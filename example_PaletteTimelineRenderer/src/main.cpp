@@ -0,0 +1,66 @@
+#include "PaletteTimelineRenderer.h"
+
+// Usage: example_PaletteTimelineRenderer [options] <file or directory>...
+//   --out <dir>             output directory (default .)
+//   --fps <n>               palette frames per second (default 30)
+//   --rate <n>              instances per second for inputs without timestamps (default 100)
+//   --window-frames <n>     ContinuousSomPalette window in frames (default 450)
+//   --size <n>              SOM width and height (default 16)
+//   --iterations <n>        iterations per map (default 4000)
+//   --learning-rate <n>     initial learning rate (default 0.015)
+//   --backend <name>        float|fixed16|fixed8 (default float)
+//   --seed <n>              initial weight seed (default 1)
+//   --lut <file.cube>       colour the features through a 3-D LUT instead of the built-in mapping
+//   --strip-every <n>       frames per palette-strip row (default 30)
+//   --threads <n>           worker threads (default: one per core)
+int main(int argc, char* argv[]){
+  TimelineRenderConfig config;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.size() < 2 || arg.compare(0, 2, "--") != 0) {
+      config.inputs.push_back(ofFilePath::getAbsolutePath(arg, false));
+      continue;
+    }
+    if (i + 1 >= argc) {
+      ofLogError("PaletteTimelineRenderer") << arg << " needs a value";
+      return 1;
+    }
+    const std::string value = argv[++i];
+    if (arg == "--out") config.outputDirectory = ofFilePath::getAbsolutePath(value, false);
+    else if (arg == "--fps") config.frameRate = ofToFloat(value);
+    else if (arg == "--rate") config.ratePerSecond = ofToDouble(value);
+    else if (arg == "--window-frames") config.timeline.windowFrames = ofToInt(value);
+    else if (arg == "--size") config.timeline.width = config.timeline.height = ofToInt(value);
+    else if (arg == "--iterations") config.timeline.numIterations = ofToInt(value);
+    else if (arg == "--learning-rate") config.timeline.initialLearningRate = ofToFloat(value);
+    else if (arg == "--seed") config.timeline.seed = static_cast<uint32_t>(ofToInt(value));
+    else if (arg == "--strip-every") config.stripEveryFrames = ofToInt(value);
+    else if (arg == "--threads") config.numThreads = ofToInt(value);
+    else if (arg == "--lut") {
+      auto lut = SomColorLut::loadCube(ofFilePath::getAbsolutePath(value, false));
+      if (!lut) return 1;
+      config.timeline.colorizer.setLut(lut);
+    } else if (arg == "--backend") {
+      if (!findSomBackendType(value, config.timeline.backend)) {
+        ofLogError("PaletteTimelineRenderer") << "unknown backend " << value << " (want float, fixed16 or fixed8)";
+        return 1;
+      }
+    } else {
+      ofLogError("PaletteTimelineRenderer") << "unknown option " << arg;
+      return 1;
+    }
+  }
+  if (config.inputs.empty()) {
+    ofLogError("PaletteTimelineRenderer") << "usage: example_PaletteTimelineRenderer [--out dir] [--fps n] [--rate n] [--threads n] ... <file or directory>...";
+    return 1;
+  }
+  if (config.outputDirectory == ".") config.outputDirectory = ofFilePath::getCurrentWorkingDirectory();
+  if (config.frameRate <= 0.0f || config.ratePerSecond <= 0.0 || config.timeline.width <= 0) {
+    ofLogError("PaletteTimelineRenderer") << "--fps, --rate and --size must be positive";
+    return 1;
+  }
+
+  // No window or GL: SomPaletteTimeline trains on plain pixels and images are saved from ofPixels.
+  PaletteTimelineRenderer renderer(config);
+  return renderer.run() == 0 ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+#include "ofApp.h"
+
+// Usage: example_SoakHarness [single|continuous] [walk|bursts|silence|cycle] [rate/s] [fps] [hours] [reportSeconds] [float|fixed16|fixed8]
+int main(int argc, char* argv[]){
+  SoakConfig config;
+  if (argc > 1) config.continuous = (std::string(argv[1]) != "single");
+  if (argc > 2) {
+    const std::string mode = argv[2];
+    if (mode == "walk") config.mode = SomInstanceGenerator::Mode::RandomWalk;
+    else if (mode == "bursts") config.mode = SomInstanceGenerator::Mode::Bursts;
+    else if (mode == "silence") config.mode = SomInstanceGenerator::Mode::Silence;
+    else config.mode = SomInstanceGenerator::Mode::Cycle;
+  }
+  if (argc > 3) config.ratePerSecond = ofToDouble(argv[3]);
+  if (argc > 4) config.frameRate = ofToFloat(argv[4]);
+  if (argc > 5) config.durationHours = ofToDouble(argv[5]);
+  if (argc > 6) config.reportSeconds = ofToDouble(argv[6]);
+  if (argc > 7 && !findSomBackendType(argv[7], config.backend)) {
+    ofLogError("SoakHarness") << "unknown backend " << argv[7] << " (want float, fixed16 or fixed8)";
+    return 1;
+  }
+
+  // Textures still need a GL context, so run with a small hidden window rather than ofAppNoWindow.
+  ofGLFWWindowSettings settings;
+  settings.setSize(64, 64);
+  settings.visible = false;
+  auto window = ofCreateWindow(settings);
+  ofRunApp(window, std::make_shared<ofApp>(config));
+  ofRunMainLoop();
+}
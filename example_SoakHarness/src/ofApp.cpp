@@ -0,0 +1,211 @@
+#include "ofApp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__linux__)
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+namespace {
+
+size_t getResidentSetBytes() {
+#if defined(__linux__)
+  std::ifstream statm("/proc/self/statm");
+  size_t totalPages = 0, residentPages = 0;
+  statm >> totalPages >> residentPages;
+  return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#elif defined(__APPLE__)
+  mach_task_basic_info info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) return 0;
+  return info.resident_size;
+#else
+  return 0;
+#endif
+}
+
+float percentile(std::vector<float>& values, float p) {
+  if (values.empty()) return 0.0f;
+  const size_t k = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5f));
+  std::nth_element(values.begin(), values.begin() + k, values.end());
+  return values[k];
+}
+
+constexpr uint64_t pendingExpiryMicros = 60 * 1000 * 1000;
+
+} // namespace
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+  ofSetFrameRate(config.frameRate);
+  ofSetVerticalSync(false);
+
+  if (config.continuous) {
+    continuousSomPalette = std::make_unique<ContinuousSomPalette>(config.width, config.height, 0.015f, config.numIterations);
+    continuousSomPalette->setBackend(config.backend);
+  } else {
+    // A single palette stops accepting instances once its iterations are used up, so give it
+    // enough for the whole run (numIterations only sets each continuous palette's lifetime).
+    const double runInstances = std::ceil(config.ratePerSecond * config.durationHours * 3600.0);
+    const int numIterations = static_cast<int>(std::min<double>(std::max<double>(runInstances, config.numIterations), std::numeric_limits<int>::max()));
+    somPalette = std::make_unique<SomPalette>(config.width, config.height, 0.01f, numIterations);
+    somPalette->setBackend(config.backend);
+  }
+  if (config.backend != SomBackendType::Float) logBackendQuality();
+  generator = SomInstanceGenerator(config.mode, config.ratePerSecond);
+
+  report.open(ofToDataPath(config.reportPath));
+  report << "elapsedSeconds,instancesSent,latencyP50Ms,latencyP90Ms,latencyP99Ms,latencyMaxMs,expired,"
+         << "queueDepth,maxQueueDepth,rssMB,rssGrowthMB,hops,hopUpdateMaxMs,updateMeanMs,updateMaxMs\n";
+
+  startMicros = ofGetElapsedTimeMicros();
+  nextReportMicros = startMicros + static_cast<uint64_t>(config.reportSeconds * 1e6);
+  startRssBytes = getResidentSetBytes();
+
+  ofLogNotice("SoakHarness") << (config.continuous ? "ContinuousSomPalette" : "SomPalette")
+                             << " " << config.width << "x" << config.height << " " << getSomBackendName(config.backend)
+                             << " at " << config.ratePerSecond << " instances/s, " << config.frameRate << " fps, "
+                             << config.durationHours << " h -> " << ofToDataPath(config.reportPath);
+}
+
+// Offline check of the chosen backend against the float reference on the same synthetic stream.
+void ofApp::logBackendQuality(){
+  // Silence would never produce anything, so fall back to a random walk.
+  const auto mode = (config.mode == SomInstanceGenerator::Mode::Silence) ? SomInstanceGenerator::Mode::RandomWalk : config.mode;
+  SomInstanceGenerator qualityGenerator { mode, 1000.0 };
+  std::vector<SomInstanceDataT> instances;
+  for (int second = 1; instances.size() < static_cast<size_t>(config.numIterations); ++second) {
+    qualityGenerator.generate(second, instances);
+  }
+  instances.resize(config.numIterations);
+
+  const SomBackendComparison result = compareSomBackends(config.backend, config.width, config.height, 0.01f, instances);
+  ofLogNotice("SoakHarness") << getSomBackendName(config.backend) << " vs float:"
+                             << " quantization error " << result.candidateQuantizationError << " vs " << result.referenceQuantizationError
+                             << ", mean weight difference " << result.meanWeightDifference
+                             << ", " << result.candidateMicrosPerUpdate << " vs " << result.referenceMicrosPerUpdate << " us/update";
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+  const uint64_t nowMicros = ofGetElapsedTimeMicros();
+
+  feed(nowMicros);
+  updatePalette();
+  measureLatency(ofGetElapsedTimeMicros());
+  maxQueueDepth = std::max(maxQueueDepth, getQueueDepth());
+
+  if (nowMicros >= nextReportMicros) {
+    writeReport(nowMicros);
+    nextReportMicros += static_cast<uint64_t>(config.reportSeconds * 1e6);
+  }
+  if (nowMicros - startMicros >= static_cast<uint64_t>(config.durationHours * 3600.0 * 1e6)) {
+    ofExit();
+  }
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+}
+
+//--------------------------------------------------------------
+void ofApp::exit(){
+  writeReport(ofGetElapsedTimeMicros());
+  report.close();
+}
+
+//--------------------------------------------------------------
+void ofApp::feed(uint64_t nowMicros) {
+  batch.clear();
+  generator.generate(static_cast<double>(nowMicros - startMicros) * 1e-6, batch);
+
+  for (const auto& instance : batch) {
+    const uint64_t before = getQueuedCount();
+    if (continuousSomPalette) continuousSomPalette->addInstanceData(instance);
+    else somPalette->addInstanceData(instance);
+    const uint64_t after = getQueuedCount();
+    if (after > before) {
+      pendingSends.emplace_back(after, nowMicros);
+      ++sentInWindow;
+    }
+  }
+}
+
+void ofApp::updatePalette() {
+  const uint64_t t0 = ofGetElapsedTimeMicros();
+  if (continuousSomPalette) continuousSomPalette->update();
+  else somPalette->update();
+  const float millis = static_cast<float>(ofGetElapsedTimeMicros() - t0) * 1e-3f;
+  updateMillis.push_back(millis);
+
+  if (continuousSomPalette && continuousSomPalette->getHopCount() != lastHopCount) {
+    lastHopCount = continuousSomPalette->getHopCount();
+    hopUpdateMillis.push_back(millis);
+  }
+}
+
+void ofApp::measureLatency(uint64_t nowMicros) {
+  const uint64_t visible = getVisibleCount();
+  while (!pendingSends.empty() && pendingSends.front().first <= visible) {
+    latencyMillis.push_back(static_cast<float>(nowMicros - pendingSends.front().second) * 1e-3f);
+    pendingSends.pop_front();
+  }
+  while (!pendingSends.empty() && nowMicros - pendingSends.front().second > pendingExpiryMicros) {
+    pendingSends.pop_front();
+    ++expiredInWindow;
+  }
+}
+
+void ofApp::writeReport(uint64_t nowMicros) {
+  const size_t rss = getResidentSetBytes();
+  const float rssMB = static_cast<float>(rss) / (1024.0f * 1024.0f);
+  const float rssGrowthMB = (static_cast<float>(rss) - static_cast<float>(startRssBytes)) / (1024.0f * 1024.0f);
+  const float elapsedSeconds = static_cast<float>(nowMicros - startMicros) * 1e-6f;
+
+  float updateMean = 0.0f;
+  for (float m : updateMillis) updateMean += m;
+  if (!updateMillis.empty()) updateMean /= static_cast<float>(updateMillis.size());
+  const float updateMax = updateMillis.empty() ? 0.0f : *std::max_element(updateMillis.begin(), updateMillis.end());
+  const float hopMax = hopUpdateMillis.empty() ? 0.0f : *std::max_element(hopUpdateMillis.begin(), hopUpdateMillis.end());
+
+  const float p50 = percentile(latencyMillis, 0.50f);
+  const float p90 = percentile(latencyMillis, 0.90f);
+  const float p99 = percentile(latencyMillis, 0.99f);
+  const float pMax = latencyMillis.empty() ? 0.0f : *std::max_element(latencyMillis.begin(), latencyMillis.end());
+
+  report << elapsedSeconds << "," << sentInWindow << ","
+         << p50 << "," << p90 << "," << p99 << "," << pMax << "," << expiredInWindow << ","
+         << getQueueDepth() << "," << maxQueueDepth << ","
+         << rssMB << "," << rssGrowthMB << ","
+         << lastHopCount << "," << hopMax << "," << updateMean << "," << updateMax << "\n";
+  report.flush();
+
+  ofLogNotice("SoakHarness") << ofToString(elapsedSeconds, 0) << "s"
+                             << " latency p50/p99 " << ofToString(p50, 1) << "/" << ofToString(p99, 1) << " ms"
+                             << ", queue " << getQueueDepth() << " (max " << maxQueueDepth << ")"
+                             << ", rss " << ofToString(rssMB, 1) << " MB (" << ofToString(rssGrowthMB, 1) << ")"
+                             << ", hops " << lastHopCount << " (max " << ofToString(hopMax, 2) << " ms)";
+
+  latencyMillis.clear();
+  updateMillis.clear();
+  hopUpdateMillis.clear();
+  sentInWindow = 0;
+  maxQueueDepth = 0;
+  expiredInWindow = 0;
+}
+
+uint64_t ofApp::getQueuedCount() const {
+  return continuousSomPalette ? continuousSomPalette->getAddedInstanceCount() : somPalette->getQueuedInstanceCount();
+}
+
+uint64_t ofApp::getVisibleCount() const {
+  return continuousSomPalette ? continuousSomPalette->getVisibleInstanceCount() : somPalette->getVisibleInstanceCount();
+}
+
+uint64_t ofApp::getQueueDepth() const {
+  return continuousSomPalette ? continuousSomPalette->getQueueDepth() : somPalette->getQueueDepth();
+}
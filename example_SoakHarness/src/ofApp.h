@@ -0,0 +1,70 @@
+#pragma once
+
+#include <deque>
+#include <fstream>
+#include <memory>
+
+#include "ofMain.h"
+#include "ofxSomPalette.h"
+#include "ofxContinuousSomPalette.hpp"
+#include "ofxSomInstanceGenerator.h"
+
+// Headless soak/latency harness: feeds a palette from a synthetic stream at a fixed frame rate and
+// periodically reports latency percentiles, queue depth, memory growth and hop timings.
+struct SoakConfig {
+  bool continuous { true }; // ContinuousSomPalette, otherwise a single SomPalette
+  SomInstanceGenerator::Mode mode { SomInstanceGenerator::Mode::Cycle };
+  double ratePerSecond { 200.0 };
+  float frameRate { 60.0f };
+  double durationHours { 10.0 };
+  double reportSeconds { 10.0 };
+  int width { 16 };
+  int height { 16 };
+  int numIterations { 4000 }; // per continuous palette; a single palette gets enough for the whole run
+  SomBackendType backend { SomBackendType::Float };
+  std::string reportPath { "soak-report.csv" };
+};
+
+class ofApp: public ofBaseApp{
+public:
+  explicit ofApp(const SoakConfig& config_) : config { config_ } {}
+
+  void setup();
+  void update();
+  void draw();
+  void exit();
+
+private:
+  SoakConfig config;
+
+  std::unique_ptr<SomPalette> somPalette;
+  std::unique_ptr<ContinuousSomPalette> continuousSomPalette;
+  SomInstanceGenerator generator;
+  std::vector<SomInstanceDataT> batch;
+
+  // (instance index, send time) for instances not yet visible
+  std::deque<std::pair<uint64_t, uint64_t>> pendingSends;
+  uint64_t startMicros { 0 };
+  uint64_t nextReportMicros { 0 };
+  size_t startRssBytes { 0 };
+  uint64_t lastHopCount { 0 };
+
+  // Current report window
+  std::vector<float> latencyMillis;
+  std::vector<float> updateMillis;
+  std::vector<float> hopUpdateMillis;
+  uint64_t sentInWindow { 0 };
+  uint64_t maxQueueDepth { 0 };
+  uint64_t expiredInWindow { 0 }; // instances that never became visible (e.g. training finished)
+
+  std::ofstream report;
+
+  void feed(uint64_t nowMicros);
+  void measureLatency(uint64_t nowMicros);
+  void writeReport(uint64_t nowMicros);
+  uint64_t getQueuedCount() const;
+  uint64_t getVisibleCount() const;
+  uint64_t getQueueDepth() const;
+  void updatePalette();
+  void logBackendQuality();
+};
@@ -1,6 +1,9 @@
 #include "ofxContinuousSomPalette.hpp"
+#include "ofxSomPaletteSampler.h"
+#include "ofxSomPaletteTrace.h"
 
 #include <algorithm>
+#include <cmath>
 
 ContinuousSomPalette::ContinuousSomPalette(int width_, int height_, float initialLearningRate_, int numIterations_)
 : width { width_ }
@@ -11,16 +14,34 @@ ContinuousSomPalette::ContinuousSomPalette(int width_, int height_, float initia
   hopFrames = std::max(1, windowFrames / 2);
 
   std::for_each(somPalettePtrs.begin(), somPalettePtrs.end(), [this](auto& p) {
-    p = std::make_unique<SomPalette>(width, height, initialLearningRate, numIterations);
-    p->setColorizerGains(colorizerGrayGain, colorizerChromaGain);
+    p = makeSomPalette();
   });
 
   blendedPixels.allocate(width, height, OF_IMAGE_COLOR);
 }
 
 void ContinuousSomPalette::addInstanceData(SomInstanceDataT instanceData) {
-  somPalettePtrs[blendFromIndex]->addInstanceData(instanceData);
-  somPalettePtrs[blendToIndex]->addInstanceData(instanceData);
+  const bool isAcceptedFrom = somPalettePtrs[blendFromIndex]->addInstanceData(instanceData);
+  const bool isAcceptedTo = somPalettePtrs[blendToIndex]->addInstanceData(instanceData);
+  if (isAcceptedFrom || isAcceptedTo) ++addedInstanceCount;
+}
+
+uint64_t ContinuousSomPalette::getVisibleInstanceCount() const {
+  // Each palette accepts a contiguous run of instances from when it was created, so its visible
+  // count maps straight onto the global index. The blend shows both, weighted by the crossfade.
+  auto getPaletteVisible = [this](int i) {
+    return static_cast<double>(firstInstanceIndex[i] + somPalettePtrs[i]->getVisibleInstanceCount());
+  };
+  const double alpha = getBlendAlpha();
+  return static_cast<uint64_t>(std::llround((1.0 - alpha) * getPaletteVisible(blendFromIndex) + alpha * getPaletteVisible(blendToIndex)));
+}
+
+uint64_t ContinuousSomPalette::getQueueDepth() const {
+  uint64_t depth = 0;
+  for (const auto& sp : somPalettePtrs) {
+    depth += sp->getQueueDepth();
+  }
+  return depth;
 }
 
 void ContinuousSomPalette::switchPalette() {
@@ -32,6 +53,7 @@ bool ContinuousSomPalette::nextPaletteIsReady() const {
 }
 
 void ContinuousSomPalette::update() {
+  SOM_PALETTE_TRACE_ZONE("ContinuousSomPalette::update");
   ++frameCount;
 
   while (frameCount - lastHopFrameCount >= hopFrames) {
@@ -41,7 +63,23 @@ void ContinuousSomPalette::update() {
   somPalettePtrs[blendFromIndex]->update();
   somPalettePtrs[blendToIndex]->update();
 
-  updateBlendedOutputs();
+  if (updateBlendedOutputs() && !sinks.empty()) {
+    SomPaletteColorsT blendedPalette;
+    for (size_t i = 0; i < blendedPalette.size(); ++i) {
+      blendedPalette[i] = getColor(i);
+    }
+    for (auto& sink : sinks) {
+      sink->publish(blendedPixels, blendedPalette);
+    }
+  }
+}
+
+void ContinuousSomPalette::addSink(std::shared_ptr<SomPaletteSink> sink) {
+  if (sink) sinks.push_back(std::move(sink));
+}
+
+void ContinuousSomPalette::removeSink(const std::shared_ptr<SomPaletteSink>& sink) {
+  sinks.erase(std::remove(sinks.begin(), sinks.end(), sink), sinks.end());
 }
 
 bool ContinuousSomPalette::keyPressed(int key) {
@@ -65,6 +103,19 @@ ofColor ContinuousSomPalette::getColor(int i) const {
   return somPalettePtrs[blendFromIndex]->getColor(i).getLerped(somPalettePtrs[blendToIndex]->getColor(i), alpha);
 }
 
+void ContinuousSomPalette::getColorsAt(const glm::vec2* uvs, ofFloatColor* colorsOut, size_t count) const {
+  if (!blendedPixels.isAllocated()) {
+    std::fill(colorsOut, colorsOut + count, ofFloatColor(0.0f, 0.0f, 0.0f));
+    return;
+  }
+  sampleBilinearMirrored(blendedPixels, uvs, colorsOut, count);
+}
+
+void ContinuousSomPalette::getColorsAt(const std::vector<glm::vec2>& uvs, std::vector<ofFloatColor>& colorsOut) const {
+  colorsOut.resize(uvs.size());
+  getColorsAt(uvs.data(), colorsOut.data(), uvs.size());
+}
+
 bool ContinuousSomPalette::isVisible() const {
   return visible;
 }
@@ -103,21 +154,73 @@ void ContinuousSomPalette::setWindowFrames(int windowFrames_) {
 }
 
 void ContinuousSomPalette::setColorizerGains(float grayGain, float chromaGain) {
-  colorizerGrayGain = grayGain;
-  colorizerChromaGain = chromaGain;
+  colorizer.setGains(grayGain, chromaGain);
   for (auto& sp : somPalettePtrs) {
-    sp->setColorizerGains(colorizerGrayGain, colorizerChromaGain);
+    sp->setColorizerGains(grayGain, chromaGain);
   }
 }
 
+void ContinuousSomPalette::setColorizer(const SomColorizer& colorizer_) {
+  colorizer = colorizer_;
+  for (auto& sp : somPalettePtrs) {
+    sp->setColorizer(colorizer);
+  }
+}
+
+void ContinuousSomPalette::setCoarseToFine(bool enabled, int coarsestSize_) {
+  coarseToFine = enabled;
+  coarsestSize = coarsestSize_;
+  for (auto& sp : somPalettePtrs) {
+    sp->setCoarseToFine(coarseToFine, coarsestSize);
+  }
+}
+
+void ContinuousSomPalette::setBackend(SomBackendType type) {
+  backendType = type;
+  for (auto& sp : somPalettePtrs) {
+    sp->setBackend(backendType);
+  }
+}
+
+void ContinuousSomPalette::setWorkerSettings(const SomWorkerSettings& settings) {
+  workerSettings = settings;
+  hasWorkerSettings = true;
+  for (auto& sp : somPalettePtrs) {
+    sp->setWorkerSettings(workerSettings);
+  }
+}
+
+void ContinuousSomPalette::setIdleDetection(bool enabled, float stabilityThreshold, int stableInstances, float noveltyRatio, bool stopTrainingWhenIdle) {
+  idleDetection = enabled;
+  idleStabilityThreshold = stabilityThreshold;
+  idleStableInstances = stableInstances;
+  idleNoveltyRatio = noveltyRatio;
+  idleStopsTraining = stopTrainingWhenIdle;
+  for (auto& sp : somPalettePtrs) {
+    sp->setIdleDetection(idleDetection, idleStabilityThreshold, idleStableInstances, idleNoveltyRatio, idleStopsTraining);
+  }
+}
+
+std::unique_ptr<SomPalette> ContinuousSomPalette::makeSomPalette() const {
+  auto p = std::make_unique<SomPalette>(width, height, initialLearningRate, numIterations);
+  p->setColorizer(colorizer);
+  if (backendType != SomBackendType::Float) p->setBackend(backendType);
+  if (coarseToFine) p->setCoarseToFine(true, coarsestSize);
+  if (hasWorkerSettings) p->setWorkerSettings(workerSettings);
+  if (idleDetection) p->setIdleDetection(true, idleStabilityThreshold, idleStableInstances, idleNoveltyRatio, idleStopsTraining);
+  return p;
+}
+
 void ContinuousSomPalette::performHop() {
+  SOM_PALETTE_TRACE_ZONE("ContinuousSomPalette::performHop");
   lastHopFrameCount = frameCount;
 
   blendFromIndex = blendToIndex;
   blendToIndex = (blendFromIndex + 1) % somPalettePtrs.size();
 
-  somPalettePtrs[blendToIndex] = std::make_unique<SomPalette>(width, height, initialLearningRate, numIterations);
-  somPalettePtrs[blendToIndex]->setColorizerGains(colorizerGrayGain, colorizerChromaGain);
+  somPalettePtrs[blendToIndex] = makeSomPalette();
+  firstInstanceIndex[blendToIndex] = addedInstanceCount;
+  ++hopCount;
 
   blendedTexture.clear();
 }
@@ -132,37 +235,48 @@ float ContinuousSomPalette::getBlendAlpha() const {
   return t * t * (3.0f - 2.0f * t);
 }
 
-void ContinuousSomPalette::updateBlendedOutputs() {
+bool ContinuousSomPalette::updateBlendedOutputs() {
+  const float alpha = getBlendAlpha();
+  // Nothing published and the crossfade has moved less than half an 8-bit step since the last
+  // blend (e.g. both palettes idle): the blended pixels and texture are still current.
+  const bool isNewPixels = somPalettePtrs[blendFromIndex]->hasNewPixels() || somPalettePtrs[blendToIndex]->hasNewPixels();
+  if (!isNewPixels && blendedTexture.isAllocated() && std::abs(alpha - blendedAlpha) * maxBlendDifference < 0.5f / 255.0f) return false;
+
+  SOM_PALETTE_TRACE_ZONE("ContinuousSomPalette::blend");
   const auto& a = somPalettePtrs[blendFromIndex]->getPixelsRef();
   const auto& b = somPalettePtrs[blendToIndex]->getPixelsRef();
 
   const int w = a.getWidth();
   const int h = a.getHeight();
-  if (w <= 0 || h <= 0) return;
+  if (w <= 0 || h <= 0) return false;
 
   if (!blendedPixels.isAllocated() || blendedPixels.getWidth() != w || blendedPixels.getHeight() != h) {
     blendedPixels.allocate(w, h, OF_IMAGE_COLOR);
   }
 
-  const float alpha = getBlendAlpha();
-
   const float* srcA = a.getData();
   const float* srcB = (b.getWidth() == w && b.getHeight() == h) ? b.getData() : nullptr;
   float* dst = blendedPixels.getData();
 
   const size_t n = static_cast<size_t>(w) * static_cast<size_t>(h) * 3;
+  float maxDifference = 0.0f;
   if (srcB) {
     for (size_t i = 0; i < n; ++i) {
       dst[i] = ofLerp(srcA[i], srcB[i], alpha);
+      maxDifference = std::max(maxDifference, std::abs(srcB[i] - srcA[i]));
     }
   } else {
     std::copy(srcA, srcA + n, dst);
   }
+  blendedAlpha = alpha;
+  maxBlendDifference = maxDifference;
 
   if (!blendedTexture.isAllocated()) {
     blendedTexture.allocate(blendedPixels, false);
     blendedTexture.setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
     blendedTexture.setTextureWrap(GL_MIRRORED_REPEAT, GL_MIRRORED_REPEAT);
   }
+  SOM_PALETTE_TRACE_ZONE("ContinuousSomPalette::textureUpload");
   blendedTexture.loadData(blendedPixels);
+  return true;
 }
@@ -3,6 +3,7 @@
 #include <array>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "ofMain.h"
 #include "ofxSomPalette.h"
@@ -26,6 +27,10 @@ public:
   bool keyPressed(int key);
   void draw();
   ofColor getColor(int i) const;
+
+  // Batch bilinear + mirrored-wrap sampling of the blended pixels at normalized UVs.
+  void getColorsAt(const glm::vec2* uvs, ofFloatColor* colorsOut, size_t count) const;
+  void getColorsAt(const std::vector<glm::vec2>& uvs, std::vector<ofFloatColor>& colorsOut) const;
   bool isVisible() const;
   void setVisible(bool visible_);
 
@@ -41,6 +46,33 @@ public:
   void setWindowFrames(int windowFrames);
 
   void setColorizerGains(float grayGain, float chromaGain);
+  void setColorizer(const SomColorizer& colorizer);
+
+  // Sinks receive the blended pixels and palette from update() whenever they are re-blended.
+  void addSink(std::shared_ptr<SomPaletteSink> sink);
+  void removeSink(const std::shared_ptr<SomPaletteSink>& sink);
+
+  // Coarse-to-fine training for every underlying palette, including those created by later hops.
+  void setCoarseToFine(bool enabled, int coarsestSize = 4);
+
+  // SOM backend for every underlying palette, including those created by later hops.
+  void setBackend(SomBackendType type);
+
+  // Worker scheduling/budget for every underlying palette, including those created by later hops.
+  void setWorkerSettings(const SomWorkerSettings& settings);
+
+  // Idle detection (see SomPalette) for every underlying palette, including those created by later hops.
+  // While neither palette publishes and the crossfade has no visible step left, the blend and its
+  // texture upload are skipped too.
+  void setIdleDetection(bool enabled, float stabilityThreshold = 0.002f, int stableInstances = 60, float noveltyRatio = 2.5f, bool stopTrainingWhenIdle = false);
+
+  // Instrumentation for latency/soak testing (see SomPalette).
+  // Added: instances accepted by at least one palette. Visible: how many of those are reflected in
+  // the blended pixels, as the crossfade-weighted mix of the two palettes' visible counts.
+  uint64_t getAddedInstanceCount() const { return addedInstanceCount; }
+  uint64_t getVisibleInstanceCount() const;
+  uint64_t getQueueDepth() const;
+  uint64_t getHopCount() const { return hopCount; }
 
   int width, height;
   float initialLearningRate;
@@ -63,11 +95,33 @@ private:
   // Blended outputs
   ofFloatPixels blendedPixels;
   ofTexture blendedTexture;
+  float blendedAlpha { 0.0f }; // alpha of the last blend
+  float maxBlendDifference { 1.0f }; // largest |a - b| in the last blend
+
+  SomColorizer colorizer;
+
+  bool coarseToFine { false };
+  int coarsestSize { 4 };
+
+  SomBackendType backendType { SomBackendType::Float };
+
+  SomWorkerSettings workerSettings;
+  bool hasWorkerSettings { false };
+
+  bool idleDetection { false };
+  float idleStabilityThreshold { 0.002f };
+  int idleStableInstances { 60 };
+  float idleNoveltyRatio { 2.5f };
+  bool idleStopsTraining { false };
+
+  uint64_t addedInstanceCount { 0 };
+  std::array<uint64_t, 2> firstInstanceIndex { 0, 0 }; // global index of each palette's first instance
+  uint64_t hopCount { 0 };
 
-  float colorizerGrayGain { 1.0f };
-  float colorizerChromaGain { 1.25f };
+  std::vector<std::shared_ptr<SomPaletteSink>> sinks;
 
+  std::unique_ptr<SomPalette> makeSomPalette() const;
   void performHop();
   float getBlendAlpha() const;
-  void updateBlendedOutputs();
+  bool updateBlendedOutputs(); // false if the blend was still current and was skipped
 };
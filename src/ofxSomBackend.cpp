@@ -0,0 +1,136 @@
+#include "ofxSomBackend.h"
+#include "ofxSomFixedPointBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+std::unique_ptr<SomBackend> makeSomBackend(SomBackendType type) {
+  switch (type) {
+    case SomBackendType::Fixed16: return std::make_unique<SomFixedPointBackend<uint16_t>>();
+    case SomBackendType::Fixed8: return std::make_unique<SomFixedPointBackend<uint8_t>>();
+    case SomBackendType::Float: break;
+  }
+  return std::make_unique<FloatSomBackend>();
+}
+
+const char* getSomBackendName(SomBackendType type) {
+  switch (type) {
+    case SomBackendType::Fixed16: return "fixed16";
+    case SomBackendType::Fixed8: return "fixed8";
+    case SomBackendType::Float: break;
+  }
+  return "float";
+}
+
+bool findSomBackendType(const std::string& name, SomBackendType& typeOut) {
+  for (SomBackendType type : { SomBackendType::Float, SomBackendType::Fixed16, SomBackendType::Fixed8 }) {
+    if (name == getSomBackendName(type)) {
+      typeOut = type;
+      return true;
+    }
+  }
+  return false;
+}
+
+void FloatSomBackend::setup(int width_, int height_, float initialLearningRate, int numIterations) {
+  width = width_;
+  height = height_;
+
+  double minInstance[3] = { 0, 0, 0 };
+  double maxInstance[3] = { 1.0, 1.0, 1.0 };
+  som.setFeaturesRange(3, minInstance, maxInstance);
+  som.setMapSize(width, height); // can go to 3 dimensions
+
+  som.setInitialLearningRate(initialLearningRate);
+  som.setNumIterations(numIterations);
+  som.setup();
+}
+
+float FloatSomBackend::updateMap(const SomInstanceDataT& instanceData) {
+  const float quantizationError = findQuantizationError(instanceData);
+  SomInstanceDataT instance = instanceData; // updateMap takes a non-const pointer
+  som.updateMap(instance.data());
+  return quantizationError;
+}
+
+float FloatSomBackend::findQuantizationError(const SomInstanceDataT& instanceData) const {
+  double minD2 = std::numeric_limits<double>::max();
+  for (int i = 0; i < width; i++) {
+    for (int j = 0; j < height; j++) {
+      const double* c = som.getMapAt(i, j);
+      const double d0 = c[0] - instanceData[0];
+      const double d1 = c[1] - instanceData[1];
+      const double d2 = c[2] - instanceData[2];
+      minD2 = std::min(minD2, d0 * d0 + d1 * d1 + d2 * d2);
+    }
+  }
+  return static_cast<float>(std::sqrt(minD2));
+}
+
+void FloatSomBackend::readWeights(std::vector<float>& weightsOut) const {
+  weightsOut.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 3);
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      const double* c = som.getMapAt(i, j);
+      for (int z = 0; z < 3; z++) {
+        weightsOut[(j * width + i) * 3 + z] = static_cast<float>(c[z]);
+      }
+    }
+  }
+}
+
+void FloatSomBackend::writeWeights(const std::vector<float>& weightsIn) {
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      double* c = som.getMapAt(i, j);
+      for (int z = 0; z < 3; z++) {
+        c[z] = weightsIn[(j * width + i) * 3 + z];
+      }
+    }
+  }
+}
+
+SomBackendComparison compareSomBackends(SomBackendType candidateType, int width, int height, float initialLearningRate, const std::vector<SomInstanceDataT>& instances) {
+  SomBackendComparison result;
+  if (instances.empty()) return result;
+  const int numIterations = static_cast<int>(instances.size());
+
+  auto reference = makeSomBackend(SomBackendType::Float);
+  auto candidate = makeSomBackend(candidateType);
+  reference->setup(width, height, initialLearningRate, numIterations);
+  candidate->setup(width, height, initialLearningRate, numIterations);
+
+  std::vector<float> referenceWeights, candidateWeights;
+  reference->readWeights(referenceWeights);
+  candidate->writeWeights(referenceWeights);
+
+  auto train = [&](SomBackend& backend) {
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& instance : instances) backend.updateMap(instance);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()) / static_cast<float>(instances.size());
+  };
+  result.referenceMicrosPerUpdate = train(*reference);
+  result.candidateMicrosPerUpdate = train(*candidate);
+
+  double referenceQe = 0.0, candidateQe = 0.0;
+  for (const auto& instance : instances) {
+    referenceQe += reference->findQuantizationError(instance);
+    candidateQe += candidate->findQuantizationError(instance);
+  }
+  result.referenceQuantizationError = static_cast<float>(referenceQe / instances.size());
+  result.candidateQuantizationError = static_cast<float>(candidateQe / instances.size());
+
+  reference->readWeights(referenceWeights);
+  candidate->readWeights(candidateWeights);
+  double sum = 0.0;
+  for (size_t k = 0; k < referenceWeights.size(); ++k) {
+    const float d = std::abs(referenceWeights[k] - candidateWeights[k]);
+    sum += d;
+    result.maxWeightDifference = std::max(result.maxWeightDifference, d);
+  }
+  result.meanWeightDifference = static_cast<float>(sum / referenceWeights.size());
+  return result;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ofxSelfOrganizingMap.h"
+
+// The doubles need to be normalised 0.0..1.0
+using SomInstanceDataT = std::array<double, 3>;
+
+// The SOM that SomPalette trains on its worker thread. Weights are exchanged as packed
+// 3-feature floats in [0..1], row-major: weights[(j * width + i) * 3 + feature].
+class SomBackend {
+public:
+  virtual ~SomBackend() = default;
+
+  virtual void setup(int width, int height, float initialLearningRate, int numIterations) = 0;
+  virtual void setNumIterations(int numIterations) = 0;
+  virtual int getCurrentIteration() const = 0;
+  virtual int getNumIterations() const = 0;
+
+  // Trains on the instance and returns its quantization error before the update: the distance to
+  // the best matching cell the update was centred on.
+  virtual float updateMap(const SomInstanceDataT& instanceData) = 0;
+  // Distance from the instance to its best matching cell.
+  virtual float findQuantizationError(const SomInstanceDataT& instanceData) const = 0;
+
+  virtual void readWeights(std::vector<float>& weightsOut) const = 0;
+  virtual void writeWeights(const std::vector<float>& weightsIn) = 0;
+};
+
+// Float: ofxSelfOrganizingMap (doubles), the reference.
+// Fixed16/Fixed8: integer weights, BMU search and neighbourhood lookup tables (SomFixedPointBackend),
+// for boards without fast double maths, e.g. Raspberry Pi.
+enum class SomBackendType { Float, Fixed16, Fixed8 };
+
+std::unique_ptr<SomBackend> makeSomBackend(SomBackendType type);
+const char* getSomBackendName(SomBackendType type);
+// The inverse of getSomBackendName; false (leaving typeOut alone) for an unknown name.
+bool findSomBackendType(const std::string& name, SomBackendType& typeOut);
+
+// ofxSelfOrganizingMap doesn't report the best matching cell it trains towards, so updateMap
+// finds it again first (one pass over the cells) to return the quantization error.
+class FloatSomBackend: public SomBackend {
+public:
+  void setup(int width, int height, float initialLearningRate, int numIterations) override;
+  void setNumIterations(int numIterations) override { som.setNumIterations(numIterations); }
+  int getCurrentIteration() const override { return som.getCurrentIteration(); }
+  int getNumIterations() const override { return som.getNumIterations(); }
+
+  float updateMap(const SomInstanceDataT& instanceData) override;
+  float findQuantizationError(const SomInstanceDataT& instanceData) const override;
+
+  void readWeights(std::vector<float>& weightsOut) const override;
+  void writeWeights(const std::vector<float>& weightsIn) override;
+
+private:
+  mutable ofxSelfOrganizingMap som; // its accessors aren't const
+  int width { 0 }, height { 0 };
+};
+
+// Trains `candidate` and the float reference from identical initial weights on the same instances,
+// then compares them. Quantization errors are means over the instances after training.
+struct SomBackendComparison {
+  float referenceQuantizationError { 0.0f };
+  float candidateQuantizationError { 0.0f };
+  float meanWeightDifference { 0.0f }; // mean |reference - candidate| over all weights
+  float maxWeightDifference { 0.0f };
+  float referenceMicrosPerUpdate { 0.0f };
+  float candidateMicrosPerUpdate { 0.0f };
+};
+
+SomBackendComparison compareSomBackends(SomBackendType candidate, int width, int height, float initialLearningRate, const std::vector<SomInstanceDataT>& instances);
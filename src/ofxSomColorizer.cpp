@@ -0,0 +1,232 @@
+#include "ofxSomColorizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+SomColorLut::SomColorLut(int size_)
+: size { std::max(2, size_) }
+{
+  // Identity: features straight to RGB.
+  rgb.resize(static_cast<size_t>(size) * size * size * 3);
+  const float scale = 1.0f / static_cast<float>(size - 1);
+  for (int i2 = 0; i2 < size; ++i2) {
+    for (int i1 = 0; i1 < size; ++i1) {
+      for (int i0 = 0; i0 < size; ++i0) {
+        setColor(i0, i1, i2, ofFloatColor(i0 * scale, i1 * scale, i2 * scale));
+      }
+    }
+  }
+}
+
+std::shared_ptr<SomColorLut> SomColorLut::loadCube(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) {
+    ofLogWarning("SomColorLut") << "can't open " << path;
+    return nullptr;
+  }
+
+  std::shared_ptr<SomColorLut> lut;
+  size_t numEntries = 0;
+  std::array<float, 3> domainMin { 0.0f, 0.0f, 0.0f };
+  std::array<float, 3> domainMax { 1.0f, 1.0f, 1.0f };
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string first;
+    if (!(fields >> first) || first[0] == '#') continue;
+
+    if (first == "LUT_3D_SIZE") {
+      int size = 0;
+      fields >> size;
+      if (size < 2 || size > 256) break;
+      lut = std::make_shared<SomColorLut>(size);
+      continue;
+    }
+    if (first == "DOMAIN_MIN" || first == "DOMAIN_MAX") {
+      auto& domain = (first == "DOMAIN_MIN") ? domainMin : domainMax;
+      if (!(fields >> domain[0] >> domain[1] >> domain[2])) {
+        ofLogWarning("SomColorLut") << path << ": malformed " << first;
+        return nullptr;
+      }
+      continue;
+    }
+    if (!lut) continue; // TITLE, LUT_1D_SIZE...
+
+    const char* begin = first.c_str();
+    char* end = nullptr;
+    const float r = std::strtof(begin, &end);
+    if (end == begin) continue;
+    float g, b;
+    if (!(fields >> g >> b) || numEntries >= lut->rgb.size() / 3) break;
+    float* c = &lut->rgb[numEntries * 3];
+    c[0] = r;
+    c[1] = g;
+    c[2] = b;
+    ++numEntries;
+  }
+
+  if (!lut || numEntries != lut->rgb.size() / 3) {
+    ofLogWarning("SomColorLut") << path << ": not a complete 3-D .cube LUT";
+    return nullptr;
+  }
+  if (!lut->setDomain(domainMin, domainMax)) {
+    ofLogWarning("SomColorLut") << path << ": DOMAIN_MAX must be greater than DOMAIN_MIN";
+    return nullptr;
+  }
+  return lut;
+}
+
+bool SomColorLut::setDomain(const std::array<float, 3>& domainMin_, const std::array<float, 3>& domainMax_) {
+  for (int z = 0; z < 3; ++z) {
+    if (!(domainMax_[z] > domainMin_[z])) return false;
+  }
+  for (int z = 0; z < 3; ++z) {
+    domainMin[z] = domainMin_[z];
+    domainScale[z] = 1.0f / (domainMax_[z] - domainMin_[z]);
+  }
+  return true;
+}
+
+void SomColorLut::setColor(int i0, int i1, int i2, const ofFloatColor& color) {
+  float* c = &rgb[((static_cast<size_t>(i2) * size + i1) * size + i0) * 3];
+  c[0] = color.r;
+  c[1] = color.g;
+  c[2] = color.b;
+}
+
+ofFloatColor SomColorLut::getColor(int i0, int i1, int i2) const {
+  const float* c = &rgb[((static_cast<size_t>(i2) * size + i1) * size + i0) * 3];
+  return ofFloatColor(c[0], c[1], c[2]);
+}
+
+void SomColorLut::lookup(const float* features, float* rgbOut, size_t numCells) const {
+  const float scale = static_cast<float>(size - 1);
+  const size_t stride1 = static_cast<size_t>(size) * 3;
+  const size_t stride2 = stride1 * size;
+
+  for (size_t i = 0; i < numCells; ++i) {
+    int index[3];
+    float t[3];
+    for (int z = 0; z < 3; ++z) {
+      const float f = (features[i * 3 + z] - domainMin[z]) * domainScale[z];
+      // NaN would survive the clamp and make the int conversion undefined.
+      const float x = (std::isnan(f) ? 0.0f : ofClamp(f, 0.0f, 1.0f)) * scale;
+      index[z] = std::min(static_cast<int>(x), size - 2);
+      t[z] = x - static_cast<float>(index[z]);
+    }
+
+    const float* c000 = &rgb[index[2] * stride2 + index[1] * stride1 + index[0] * 3];
+    const float* c010 = c000 + stride1;
+    const float* c001 = c000 + stride2;
+    const float* c011 = c001 + stride1;
+    for (int ch = 0; ch < 3; ++ch) {
+      const float c00 = c000[ch] + t[0] * (c000[ch + 3] - c000[ch]);
+      const float c10 = c010[ch] + t[0] * (c010[ch + 3] - c010[ch]);
+      const float c01 = c001[ch] + t[0] * (c001[ch + 3] - c001[ch]);
+      const float c11 = c011[ch] + t[0] * (c011[ch + 3] - c011[ch]);
+      const float c0 = c00 + t[1] * (c10 - c00);
+      const float c1 = c01 + t[1] * (c11 - c01);
+      rgbOut[i * 3 + ch] = c0 + t[2] * (c1 - c0);
+    }
+  }
+}
+
+SomColorizer::Matrix SomColorizer::makeGainMatrix(float grayGain, float chromaGain) {
+  // SomPalette::colorizeFeatures expanded: with x = f - 0.5,
+  //   r = 0.5 + g*x0 + c*x1
+  //   g = 0.5 + g*x0 - c/2*x1 - c*sqrt(3)/2*x2
+  //   b = 0.5 + g*x0 - c/2*x1 + c*sqrt(3)/2*x2
+  constexpr float SQRT3_OVER_2 = 0.8660254037844386f;
+  const float half = 0.5f * chromaGain;
+  const float rotated = SQRT3_OVER_2 * chromaGain;
+
+  Matrix result;
+  result.m = {
+    grayGain, chromaGain, 0.0f,
+    grayGain, -half, -rotated,
+    grayGain, -half, rotated,
+  };
+  for (int row = 0; row < 3; ++row) {
+    const float* m = &result.m[row * 3];
+    result.offset[row] = 0.5f - 0.5f * (m[0] + m[1] + m[2]);
+  }
+  return result;
+}
+
+void SomColorizer::setGains(float grayGain_, float chromaGain_) {
+  if (mode == Mode::Gains && grayGain_ == grayGain && chromaGain_ == chromaGain) return;
+  mode = Mode::Gains;
+  grayGain = grayGain_;
+  chromaGain = chromaGain_;
+  matrix = makeGainMatrix(grayGain, chromaGain);
+  lut.reset();
+}
+
+void SomColorizer::setMatrix(const Matrix& matrix_) {
+  mode = Mode::Matrix;
+  matrix = matrix_;
+  lut.reset();
+}
+
+void SomColorizer::setLut(std::shared_ptr<const SomColorLut> lut_) {
+  if (!lut_) {
+    setGains(grayGain, chromaGain);
+    return;
+  }
+  mode = Mode::Lut;
+  lut = std::move(lut_);
+}
+
+void SomColorizer::colorize(const float* features, float* rgbOut, size_t numCells) const {
+  if (mode == Mode::Lut) {
+    lut->lookup(features, rgbOut, numCells);
+    return;
+  }
+
+  // Coefficients in locals so the compiler can keep them in registers and vectorize across cells.
+  const float m00 = matrix.m[0], m01 = matrix.m[1], m02 = matrix.m[2];
+  const float m10 = matrix.m[3], m11 = matrix.m[4], m12 = matrix.m[5];
+  const float m20 = matrix.m[6], m21 = matrix.m[7], m22 = matrix.m[8];
+  const float o0 = matrix.offset[0], o1 = matrix.offset[1], o2 = matrix.offset[2];
+
+  for (size_t i = 0; i < numCells; ++i) {
+    const float f0 = features[i * 3];
+    const float f1 = features[i * 3 + 1];
+    const float f2 = features[i * 3 + 2];
+    rgbOut[i * 3] = std::min(1.0f, std::max(0.0f, m00 * f0 + m01 * f1 + m02 * f2 + o0));
+    rgbOut[i * 3 + 1] = std::min(1.0f, std::max(0.0f, m10 * f0 + m11 * f1 + m12 * f2 + o1));
+    rgbOut[i * 3 + 2] = std::min(1.0f, std::max(0.0f, m20 * f0 + m21 * f1 + m22 * f2 + o2));
+  }
+}
+
+void SomColorizer::colorize(const float* f0, const float* f1, const float* f2, float* rgbOut, size_t numCells) const {
+  if (mode == Mode::Lut) {
+    // The LUT gathers per cell anyway, so interleave in small blocks and reuse the packed path.
+    constexpr size_t blockCells = 64;
+    float block[blockCells * 3];
+    for (size_t start = 0; start < numCells; start += blockCells) {
+      const size_t n = std::min(blockCells, numCells - start);
+      for (size_t i = 0; i < n; ++i) {
+        block[i * 3] = f0[start + i];
+        block[i * 3 + 1] = f1[start + i];
+        block[i * 3 + 2] = f2[start + i];
+      }
+      lut->lookup(block, rgbOut + start * 3, n);
+    }
+    return;
+  }
+
+  const float m00 = matrix.m[0], m01 = matrix.m[1], m02 = matrix.m[2];
+  const float m10 = matrix.m[3], m11 = matrix.m[4], m12 = matrix.m[5];
+  const float m20 = matrix.m[6], m21 = matrix.m[7], m22 = matrix.m[8];
+  const float o0 = matrix.offset[0], o1 = matrix.offset[1], o2 = matrix.offset[2];
+
+  for (size_t i = 0; i < numCells; ++i) {
+    rgbOut[i * 3] = std::min(1.0f, std::max(0.0f, m00 * f0[i] + m01 * f1[i] + m02 * f2[i] + o0));
+    rgbOut[i * 3 + 1] = std::min(1.0f, std::max(0.0f, m10 * f0[i] + m11 * f1[i] + m12 * f2[i] + o1));
+    rgbOut[i * 3 + 2] = std::min(1.0f, std::max(0.0f, m20 * f0[i] + m21 * f1[i] + m22 * f2[i] + o2));
+  }
+}
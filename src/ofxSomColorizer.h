@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ofMain.h"
+
+// A 3-D colour lookup table over feature space, sampled trilinearly. Entries are RGB floats with f0
+// varying fastest, the same order as .cube files:
+//   rgb[((i2 * size + i1) * size + i0) * 3 + channel]
+class SomColorLut {
+public:
+  explicit SomColorLut(int size = 17);
+
+  // Reads an Adobe/Resolve .cube 3-D LUT, including its DOMAIN_MIN/DOMAIN_MAX. Returns nullptr if
+  // it can't be read.
+  static std::shared_ptr<SomColorLut> loadCube(const std::string& path);
+
+  int getSize() const { return size; }
+  void setColor(int i0, int i1, int i2, const ofFloatColor& color);
+  ofFloatColor getColor(int i0, int i1, int i2) const;
+
+  // Feature range the table spans per axis (0..1 unless set); features outside it are clamped.
+  // Returns false, leaving the domain unchanged, unless max > min on every axis.
+  bool setDomain(const std::array<float, 3>& domainMin, const std::array<float, 3>& domainMax);
+
+  // Packed feature triples in, packed RGB out. NaN features are treated as the domain minimum.
+  void lookup(const float* features, float* rgbOut, size_t numCells) const;
+
+private:
+  int size;
+  std::vector<float> rgb;
+  std::array<float, 3> domainMin { 0.0f, 0.0f, 0.0f };
+  std::array<float, 3> domainScale { 1.0f, 1.0f, 1.0f }; // 1 / (max - min)
+};
+
+// Feature -> RGB mapping for whole weight buffers.
+//
+// The built-in mapping (SomPalette::colorizeFeatures) is affine before its clamp, so setGains()
+// folds the gains into a 3x3 matrix plus offset once, and colorize() is then a single
+// auto-vectorizable multiply-add-clamp pass over every cell. A user matrix replaces the built-in
+// one at the same cost; a LUT replaces the matrix altogether for non-linear mappings.
+class SomColorizer {
+public:
+  // rgb = clamp(m * features + offset, 0, 1), m row-major.
+  struct Matrix {
+    std::array<float, 9> m { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+    std::array<float, 3> offset { 0.0f, 0.0f, 0.0f };
+  };
+  enum class Mode { Gains, Matrix, Lut };
+
+  SomColorizer() { setGains(1.0f, 1.25f); }
+
+  // Selects the built-in mapping. Cheap to call every frame: the matrix is only rebuilt when the
+  // gains (or mode) change.
+  void setGains(float grayGain, float chromaGain);
+  void setMatrix(const Matrix& matrix);
+  void setLut(std::shared_ptr<const SomColorLut> lut); // nullptr returns to the built-in mapping
+
+  Mode getMode() const { return mode; }
+  const Matrix& getMatrix() const { return matrix; }
+  const std::shared_ptr<const SomColorLut>& getLut() const { return lut; }
+
+  // Packed feature triples in, packed RGB out (e.g. SomBackend weights into ofFloatPixels data).
+  void colorize(const float* features, float* rgbOut, size_t numCells) const;
+  // Planar features, e.g. one map of SomPaletteBank's arena.
+  void colorize(const float* f0, const float* f1, const float* f2, float* rgbOut, size_t numCells) const;
+
+  static Matrix makeGainMatrix(float grayGain, float chromaGain);
+
+private:
+  Mode mode { Mode::Gains };
+  Matrix matrix;
+  float grayGain { 0.0f }, chromaGain { 0.0f };
+  std::shared_ptr<const SomColorLut> lut;
+};
@@ -0,0 +1,165 @@
+#include "ofxSomFixedPointBackend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+template<typename WeightT>
+void SomFixedPointBackend<WeightT>::setup(int width_, int height_, float initialLearningRate_, int numIterations_) {
+  width = width_;
+  height = height_;
+  initialLearningRate = initialLearningRate_;
+  iteration = 0;
+  mapRadius = std::max(width, height) / 2.0f;
+
+  const size_t numCells = static_cast<size_t>(width) * static_cast<size_t>(height);
+  w0.resize(numCells);
+  w1.resize(numCells);
+  w2.resize(numCells);
+  distances.resize(numCells);
+
+  // Seeded per instance so palettes (e.g. ContinuousSomPalette's pair) don't all start from the
+  // same weights.
+  std::mt19937 rng { std::random_device {}() };
+  std::uniform_int_distribution<int> dist { 0, maxWeight };
+  for (size_t i = 0; i < numCells; ++i) {
+    w0[i] = static_cast<WeightT>(dist(rng));
+    w1[i] = static_cast<WeightT>(dist(rng));
+    w2[i] = static_cast<WeightT>(dist(rng));
+  }
+
+  setNumIterations(numIterations_);
+}
+
+template<typename WeightT>
+void SomFixedPointBackend<WeightT>::setNumIterations(int numIterations_) {
+  numIterations = std::max(1, numIterations_);
+  // A map with radius <= 1 has nothing to shrink; keep the radius decaying gently rather than dividing by log(1).
+  const float logRadius = std::log(mapRadius);
+  timeConstant = (logRadius > 0.0f) ? numIterations / logRadius : static_cast<float>(numIterations);
+  lutIteration = -1;
+}
+
+template<typename WeightT>
+void SomFixedPointBackend<WeightT>::quantize(const SomInstanceDataT& instanceData, int32_t x[3]) {
+  for (int z = 0; z < 3; ++z) {
+    x[z] = static_cast<int32_t>(std::lround(std::clamp(instanceData[z], 0.0, 1.0) * maxWeight));
+  }
+}
+
+template<typename WeightT>
+void SomFixedPointBackend<WeightT>::updateNeighbourhood() {
+  const float t = static_cast<float>(iteration);
+  const float radius = mapRadius * std::exp(-t / timeConstant);
+  const float learningRate = initialLearningRate * std::exp(-t / static_cast<float>(numIterations));
+  const float radius2 = radius * radius;
+
+  // Entries for every squared grid distance inside the radius; the BMU (0) is always included.
+  const size_t numEntries = std::max<size_t>(1, static_cast<size_t>(std::ceil(radius2)));
+  neighbourhood.resize(numEntries);
+  const float invTwoRadius2 = (radius2 > 0.0f) ? 1.0f / (2.0f * radius2) : 0.0f;
+  for (size_t g2 = 0; g2 < numEntries; ++g2) {
+    const float influence = learningRate * std::exp(-static_cast<float>(g2) * invTwoRadius2);
+    neighbourhood[g2] = std::min<int32_t>(32767, static_cast<int32_t>(std::lround(influence * 32768.0f)));
+  }
+  lutRadius = static_cast<int>(std::ceil(radius));
+  lutIteration = iteration;
+}
+
+template<typename WeightT>
+size_t SomFixedPointBackend<WeightT>::findBestMatchingCell(const int32_t x[3]) const {
+  const size_t n = w0.size();
+  uint32_t* d = distances.data();
+
+  // Squared distances in one vectorizable pass, then a scalar argmin.
+  for (size_t i = 0; i < n; ++i) {
+    const int32_t d0 = (static_cast<int32_t>(w0[i]) - x[0]) >> distanceShift;
+    const int32_t d1 = (static_cast<int32_t>(w1[i]) - x[1]) >> distanceShift;
+    const int32_t d2 = (static_cast<int32_t>(w2[i]) - x[2]) >> distanceShift;
+    d[i] = static_cast<uint32_t>(d0 * d0) + static_cast<uint32_t>(d1 * d1) + static_cast<uint32_t>(d2 * d2);
+  }
+  return static_cast<size_t>(std::min_element(d, d + n) - d);
+}
+
+template<typename WeightT>
+float SomFixedPointBackend<WeightT>::updateMap(const SomInstanceDataT& instanceData) {
+  if (iteration >= numIterations || w0.empty()) return findQuantizationError(instanceData);
+
+  int32_t x[3];
+  quantize(instanceData, x);
+  const size_t bmu = findBestMatchingCell(x);
+  const float quantizationError = getDistance(bmu, x);
+  const int bx = static_cast<int>(bmu % width);
+  const int by = static_cast<int>(bmu / width);
+
+  if (lutIteration < 0 || iteration - lutIteration >= lutRefreshIterations) updateNeighbourhood();
+
+  const int32_t numEntries = static_cast<int32_t>(neighbourhood.size());
+  const int yMin = std::max(0, by - lutRadius), yMax = std::min(height - 1, by + lutRadius);
+  const int xMin = std::max(0, bx - lutRadius), xMax = std::min(width - 1, bx + lutRadius);
+
+  for (int j = yMin; j <= yMax; ++j) {
+    const int32_t dy2 = (j - by) * (j - by);
+    for (int i = xMin; i <= xMax; ++i) {
+      const int32_t g2 = (i - bx) * (i - bx) + dy2;
+      if (g2 >= numEntries) continue;
+      const int32_t influence = neighbourhood[g2];
+      const size_t c = static_cast<size_t>(j) * width + i;
+
+      // xorshift32 for the rounding offset
+      rngState ^= rngState << 13;
+      rngState ^= rngState >> 17;
+      rngState ^= rngState << 5;
+      const int32_t rounding = static_cast<int32_t>(rngState & 0x7fff);
+
+      // |influence| < 2^15 and |x - w| < 2^16, so the product fits in int32_t. The result always
+      // lies between w and x, so no clamping is needed.
+      w0[c] = static_cast<WeightT>(w0[c] + ((influence * (x[0] - w0[c]) + rounding) >> 15));
+      w1[c] = static_cast<WeightT>(w1[c] + ((influence * (x[1] - w1[c]) + rounding) >> 15));
+      w2[c] = static_cast<WeightT>(w2[c] + ((influence * (x[2] - w2[c]) + rounding) >> 15));
+    }
+  }
+  ++iteration;
+  return quantizationError;
+}
+
+template<typename WeightT>
+float SomFixedPointBackend<WeightT>::findQuantizationError(const SomInstanceDataT& instanceData) const {
+  if (w0.empty()) return 0.0f;
+  int32_t x[3];
+  quantize(instanceData, x);
+  return getDistance(findBestMatchingCell(x), x);
+}
+
+template<typename WeightT>
+float SomFixedPointBackend<WeightT>::getDistance(size_t cell, const int32_t x[3]) const {
+  constexpr float scale = 1.0f / maxWeight;
+  const float d0 = (static_cast<int32_t>(w0[cell]) - x[0]) * scale;
+  const float d1 = (static_cast<int32_t>(w1[cell]) - x[1]) * scale;
+  const float d2 = (static_cast<int32_t>(w2[cell]) - x[2]) * scale;
+  return std::sqrt(d0 * d0 + d1 * d1 + d2 * d2);
+}
+
+template<typename WeightT>
+void SomFixedPointBackend<WeightT>::readWeights(std::vector<float>& weightsOut) const {
+  constexpr float scale = 1.0f / maxWeight;
+  weightsOut.resize(w0.size() * 3);
+  for (size_t i = 0; i < w0.size(); ++i) {
+    weightsOut[i * 3] = w0[i] * scale;
+    weightsOut[i * 3 + 1] = w1[i] * scale;
+    weightsOut[i * 3 + 2] = w2[i] * scale;
+  }
+}
+
+template<typename WeightT>
+void SomFixedPointBackend<WeightT>::writeWeights(const std::vector<float>& weightsIn) {
+  auto toWeight = [](float v) { return static_cast<WeightT>(std::lround(std::clamp(v, 0.0f, 1.0f) * maxWeight)); };
+  for (size_t i = 0; i < w0.size(); ++i) {
+    w0[i] = toWeight(weightsIn[i * 3]);
+    w1[i] = toWeight(weightsIn[i * 3 + 1]);
+    w2[i] = toWeight(weightsIn[i * 3 + 2]);
+  }
+}
+
+template class SomFixedPointBackend<uint8_t>;
+template class SomFixedPointBackend<uint16_t>;
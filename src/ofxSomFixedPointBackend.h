@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "ofxSomBackend.h"
+
+// Integer SOM for low-power targets: weights are WeightT (uint8_t or uint16_t) scaled so the
+// type's max is 1.0, BMU search uses integer squared distances, and the Gaussian neighbourhood
+// (already scaled by the learning rate) comes from a Q15 lookup table indexed by squared grid
+// distance. Follows ofxSelfOrganizingMap's schedule so the two are comparable
+// (see compareSomBackends).
+//
+// Updates use stochastic rounding: with small learning rates the per-cell step is often below
+// one weight unit, and plain rounding would freeze 8-bit maps early.
+template<typename WeightT>
+class SomFixedPointBackend: public SomBackend {
+  static_assert(std::is_same<WeightT, uint8_t>::value || std::is_same<WeightT, uint16_t>::value, "8 or 16 bit weights");
+
+public:
+  void setup(int width, int height, float initialLearningRate, int numIterations) override;
+  void setNumIterations(int numIterations) override;
+  int getCurrentIteration() const override { return iteration; }
+  int getNumIterations() const override { return numIterations; }
+
+  float updateMap(const SomInstanceDataT& instanceData) override;
+  float findQuantizationError(const SomInstanceDataT& instanceData) const override;
+
+  void readWeights(std::vector<float>& weightsOut) const override;
+  void writeWeights(const std::vector<float>& weightsIn) override;
+
+  static constexpr int maxWeight = std::numeric_limits<WeightT>::max();
+
+private:
+  // The neighbourhood shrinks slowly (timeConstant is hundreds of iterations), so the table only
+  // needs rebuilding every few iterations.
+  static constexpr int lutRefreshIterations = 16;
+  // Drop low bits of 16-bit differences so three squares fit in uint32_t.
+  static constexpr int distanceShift = (sizeof(WeightT) == 2) ? 4 : 0;
+
+  int width { 0 }, height { 0 };
+  float initialLearningRate { 0.0f };
+  int numIterations { 0 };
+  int iteration { 0 };
+  float mapRadius { 1.0f };
+  float timeConstant { 1.0f };
+
+  std::vector<WeightT> w0, w1, w2; // one plane per feature
+  mutable std::vector<uint32_t> distances; // scratch for BMU search
+
+  std::vector<int32_t> neighbourhood; // Q15 learning rate x influence, by squared grid distance
+  int lutRadius { 0 }; // cells further than this (on either axis) are outside the neighbourhood
+  int lutIteration { -1 };
+  uint32_t rngState { 0x9e3779b9u };
+
+  void updateNeighbourhood();
+  size_t findBestMatchingCell(const int32_t x[3]) const;
+  float getDistance(size_t cell, const int32_t x[3]) const;
+  static void quantize(const SomInstanceDataT& instanceData, int32_t x[3]);
+};
@@ -0,0 +1,68 @@
+#include "ofxSomInstanceGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+SomInstanceGenerator::SomInstanceGenerator(Mode mode_, double ratePerSecond_, uint32_t seed) :
+mode { mode_ },
+ratePerSecond { ratePerSecond_ },
+rng { seed }
+{}
+
+SomInstanceGenerator::Mode SomInstanceGenerator::getActiveMode(double nowSeconds) const {
+  if (mode != Mode::Cycle) return mode;
+  const int phase = static_cast<int>(std::floor(nowSeconds / cycleSeconds)) % 3;
+  if (phase == 0) return Mode::RandomWalk;
+  if (phase == 1) return Mode::Bursts;
+  return Mode::Silence;
+}
+
+size_t SomInstanceGenerator::generate(double nowSeconds, std::vector<SomInstanceDataT>& out) {
+  if (lastSeconds < 0.0) {
+    lastSeconds = nowSeconds;
+    return 0;
+  }
+  const double dt = std::max(0.0, nowSeconds - lastSeconds);
+  lastSeconds = nowSeconds;
+
+  const Mode activeMode = getActiveMode(nowSeconds);
+  if (activeMode == Mode::Silence) {
+    owed = 0.0;
+    return 0;
+  }
+  if (activeMode == Mode::Bursts) {
+    const double period = burstSeconds + gapSeconds;
+    if (std::fmod(nowSeconds, period) >= burstSeconds) {
+      owed = 0.0;
+      return 0;
+    }
+  }
+
+  owed += dt * ratePerSecond;
+  const size_t count = static_cast<size_t>(owed);
+  owed -= static_cast<double>(count);
+
+  for (size_t i = 0; i < count; ++i) {
+    out.push_back(nextInstance(activeMode));
+  }
+  return count;
+}
+
+SomInstanceDataT SomInstanceGenerator::nextInstance(Mode activeMode) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::normal_distribution<double> step(0.0, stepSize);
+
+  if (activeMode == Mode::Bursts && uniform(rng) < 0.05) {
+    // Occasionally jump somewhere new so bursts exercise novelty.
+    for (auto& v : current) v = uniform(rng);
+  } else {
+    for (auto& v : current) {
+      v += step(rng);
+      // Reflect off the [0..1] walls rather than sticking to them.
+      if (v < 0.0) v = -v;
+      if (v > 1.0) v = 2.0 - v;
+      v = std::clamp(v, 0.0, 1.0);
+    }
+  }
+  return current;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "ofxSomPalette.h"
+
+// Synthetic SomInstanceDataT stream for soak and latency testing without audio.
+//
+// generate() is called with the current time and returns every instance due since the previous
+// call at the configured rate (up to kHz), so a frame-rate driver still sees a realistic stream.
+// Deterministic for a given seed.
+class SomInstanceGenerator {
+public:
+  enum class Mode {
+    RandomWalk, // continuous small steps, like a slowly evolving sound
+    Bursts, // short dense bursts that jump around feature space, separated by gaps
+    Silence, // no instances at all
+    Cycle // RandomWalk -> Bursts -> Silence, cycleSeconds each
+  };
+
+  SomInstanceGenerator(Mode mode_ = Mode::RandomWalk, double ratePerSecond_ = 60.0, uint32_t seed = 1);
+
+  void setMode(Mode mode_) { mode = mode_; }
+  void setRate(double ratePerSecond_) { ratePerSecond = ratePerSecond_; }
+  void setStepSize(double stepSize_) { stepSize = stepSize_; } // random-walk step per instance
+  void setBurstTiming(double burstSeconds_, double gapSeconds_) { burstSeconds = burstSeconds_; gapSeconds = gapSeconds_; }
+  void setCycleSeconds(double cycleSeconds_) { cycleSeconds = cycleSeconds_; }
+
+  // Appends the instances due up to nowSeconds to out; returns how many were appended.
+  size_t generate(double nowSeconds, std::vector<SomInstanceDataT>& out);
+
+  Mode getActiveMode(double nowSeconds) const;
+
+private:
+  Mode mode;
+  double ratePerSecond;
+  double stepSize { 0.01 };
+  double burstSeconds { 0.25 };
+  double gapSeconds { 1.0 };
+  double cycleSeconds { 60.0 };
+
+  std::mt19937 rng;
+  SomInstanceDataT current { 0.5, 0.5, 0.5 };
+  double lastSeconds { -1.0 };
+  double owed { 0.0 }; // fractional instances carried between calls
+
+  SomInstanceDataT nextInstance(Mode activeMode);
+};
@@ -1,10 +1,46 @@
 #include "ofxSomPalette.h"
 #include "ofTexture.h"
+#include "ofxSomPaletteSampler.h"
+#include "ofxSomPaletteTrace.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <limits>
+#include <numeric>
 #include <vector>
 
+namespace {
+
+// Bilinear resample of a packed 3-feature grid, aligning corner cells so the map's ordering is kept.
+void resampleWeights(const std::vector<float>& src, int sw, int sh, std::vector<float>& dst, int dw, int dh) {
+  dst.resize(static_cast<size_t>(dw) * static_cast<size_t>(dh) * 3);
+  const float sx = (dw > 1) ? static_cast<float>(sw - 1) / static_cast<float>(dw - 1) : 0.0f;
+  const float sy = (dh > 1) ? static_cast<float>(sh - 1) / static_cast<float>(dh - 1) : 0.0f;
+
+  for (int j = 0; j < dh; ++j) {
+    const float fy = j * sy;
+    const int y0 = std::min(static_cast<int>(fy), sh - 1);
+    const int y1 = std::min(y0 + 1, sh - 1);
+    const float ty = fy - y0;
+    for (int i = 0; i < dw; ++i) {
+      const float fx = i * sx;
+      const int x0 = std::min(static_cast<int>(fx), sw - 1);
+      const int x1 = std::min(x0 + 1, sw - 1);
+      const float tx = fx - x0;
+      for (int z = 0; z < 3; ++z) {
+        const float a = ofLerp(src[(y0 * sw + x0) * 3 + z], src[(y0 * sw + x1) * 3 + z], tx);
+        const float b = ofLerp(src[(y1 * sw + x0) * 3 + z], src[(y1 * sw + x1) * 3 + z], tx);
+        dst[(j * dw + i) * 3 + z] = ofLerp(a, b, ty);
+      }
+    }
+  }
+}
+
+constexpr int64_t commandPollMillis = 10; // how long an idle worker waits before checking for commands
+
+} // namespace
+
 SomPalette::SomPalette(int width_, int height_, float initialLearningRate_, int numIterations_) :
 width { width_ },
 height { height_ },
@@ -22,32 +58,52 @@ numIterations { numIterations_ }
     }
   }
 
-  setupSom(initialLearningRate_, numIterations_);
+  // Safe to set up directly: the worker isn't running yet.
+  setupSomAtSize(width, height, initialLearningRate, numIterations);
+  publishIterationCounts();
   startThread();
 }
 
 SomPalette::~SomPalette() {
+  stopThread();
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wakeCondition.notify_one();
+  }
   newInstanceData.close();
   newPalettePixels.close();
   waitForThread(true);
 }
 
-void SomPalette::setupSom(float initialLearningRate, int numIterations) {
-  double minInstance[3] = { 0, 0, 0 };
-  double maxInstance[3] = { 1.0, 1.0, 1.0 };
-  som.setFeaturesRange(3, minInstance, maxInstance);
-  som.setMapSize(width, height); // can go to 3 dimensions
-  
-  som.setInitialLearningRate(initialLearningRate);
-  som.setNumIterations(numIterations);
-  som.setup();
+void SomPalette::setupSom(float initialLearningRate_, int numIterations_) {
+  WorkerCommand command;
+  command.type = WorkerCommand::Type::Setup;
+  command.initialLearningRate = initialLearningRate_;
+  command.numIterations = numIterations_;
+  postCommand(std::move(command));
+  reset();
+}
+
+void SomPalette::setupSomAtSize(int w, int h, float initialLearningRate, int numIterations) {
+  somWidth = w;
+  somHeight = h;
+  som = makeSomBackend(backendType);
+  som->setup(w, h, initialLearningRate, numIterations);
 }
 
 void SomPalette::reset() {
-  som = ofxSelfOrganizingMap();
-  setupSom(initialLearningRate, numIterations);
-  newInstanceData.clear();
-  shouldWarmStartOnNextInstance = true;
+  // The worker drops instances queued before this point (still counting them as consumed, so
+  // the queued/consumed counters stay balanced), and update() drops frames published before it.
+  WorkerCommand command;
+  command.type = WorkerCommand::Type::Reset;
+  command.generation = ++generation;
+  command.discardThroughCount = queuedInstanceCount.load();
+  const int sourceCount = numSources.load();
+  for (int i = 0; i < sourceCount; ++i) {
+    command.sourceDiscardThroughCounts[i] = sourceLanes[i]->accepted.load();
+  }
+  postCommand(std::move(command));
+  idle.store(false);
 
   palette.fill(ofColor::black);
   for (int x = 0; x < width; ++x) {
@@ -57,96 +113,643 @@ void SomPalette::reset() {
   }
 }
 
-void SomPalette::warmStartFromFirstInstance(float mix) {
-  warmStartMix.store(mix);
+void SomPalette::setNumIterations(int numIterations_) {
+  WorkerCommand command;
+  command.type = WorkerCommand::Type::SetNumIterations;
+  command.numIterations = numIterations_;
+  postCommand(std::move(command));
+}
+
+void SomPalette::setCoarseToFine(bool enabled, int coarsestSize_) {
+  requestedCoarseToFine = enabled;
+  WorkerCommand command;
+  command.type = WorkerCommand::Type::SetCoarseToFine;
+  command.enabled = enabled;
+  command.coarsestSize = std::max(2, coarsestSize_);
+  postCommand(std::move(command));
+  reset();
+}
+
+void SomPalette::setBackend(SomBackendType type) {
+  requestedBackendType = type;
+  WorkerCommand command;
+  command.type = WorkerCommand::Type::SetBackend;
+  command.backendType = type;
+  postCommand(std::move(command));
+  reset();
+}
+
+void SomPalette::loadState(std::vector<float> weights, int weightsWidth, int weightsHeight) {
+  if (weightsWidth <= 0 || weightsHeight <= 0 || weights.size() != static_cast<size_t>(weightsWidth) * static_cast<size_t>(weightsHeight) * 3) {
+    ofLogWarning("SomPalette") << "loadState: expected " << weightsWidth << "x" << weightsHeight << "x3 weights, got " << weights.size();
+    return;
+  }
+  WorkerCommand command;
+  command.type = WorkerCommand::Type::LoadState;
+  command.weights = std::move(weights);
+  command.weightsWidth = weightsWidth;
+  command.weightsHeight = weightsHeight;
+  postCommand(std::move(command));
+}
+
+void SomPalette::postCommand(WorkerCommand&& command) {
+  flushOverflowCommands();
+  if (overflowCommands.empty() && commands.push(std::move(command))) return;
+  // Ring full (worker stalled): keep the order and retry on the next call or update().
+  overflowCommands.push_back(std::move(command));
+}
+
+void SomPalette::flushOverflowCommands() {
+  while (!overflowCommands.empty() && commands.push(std::move(overflowCommands.front()))) {
+    overflowCommands.pop_front();
+  }
+}
+
+void SomPalette::processCommands() {
+  WorkerCommand command;
+  bool isApplied = false;
+  while (commands.pop(command)) {
+    applyCommand(command);
+    isApplied = true;
+  }
+  if (isApplied) publishIterationCounts();
+}
+
+void SomPalette::applyCommand(WorkerCommand& command) {
+  SOM_PALETTE_TRACE_ZONE("SomPalette::applyCommand");
+  switch (command.type) {
+    case WorkerCommand::Type::Reset:
+      workerGeneration = command.generation;
+      discardThroughCount = command.discardThroughCount;
+      for (int i = 0; i < numSources.load(); ++i) {
+        // A source registered after the reset was posted has nothing to discard.
+        sourceLanes[i]->discardThroughCount = command.sourceDiscardThroughCounts[i];
+      }
+      resetSom();
+      break;
+    case WorkerCommand::Type::Setup:
+      initialLearningRate = command.initialLearningRate;
+      numIterations = command.numIterations;
+      break;
+    case WorkerCommand::Type::SetNumIterations:
+      numIterations = command.numIterations;
+      if (coarseToFine) {
+        // Finished levels keep the iterations they ran; what's left of the new total is re-split
+        // across the current and later levels.
+        completedLevelIterations = 0;
+        for (size_t l = 0; l < level; ++l) completedLevelIterations += levelIterations[l];
+        splitLevelIterations(level, numIterations - completedLevelIterations);
+        som->setNumIterations(levelIterations[level]);
+        // If the current level is already past its new share, move on now: once the total is
+        // reached no more instances arrive to trigger the advance, leaving a coarse map on show.
+        while (level + 1 < levelSizes.size() && som->getCurrentIteration() >= som->getNumIterations()) {
+          advanceCoarseToFineLevel();
+        }
+      } else {
+        som->setNumIterations(numIterations);
+      }
+      break;
+    case WorkerCommand::Type::SetCoarseToFine:
+      coarseToFine = command.enabled;
+      coarsestSize = command.coarsestSize;
+      break;
+    case WorkerCommand::Type::SetBackend:
+      backendType = command.backendType;
+      break;
+    case WorkerCommand::Type::WarmStart:
+      warmStartMix = command.mix;
+      shouldWarmStartOnNextInstance = true;
+      break;
+    case WorkerCommand::Type::SetColorizerGains:
+      colorizer.setGains(command.grayGain, command.chromaGain);
+      break;
+    case WorkerCommand::Type::SetColorizer:
+      colorizer = command.colorizer;
+      break;
+    case WorkerCommand::Type::LoadState:
+      if (command.weightsWidth == somWidth && command.weightsHeight == somHeight) {
+        som->writeWeights(command.weights);
+      } else {
+        resampleWeights(command.weights, command.weightsWidth, command.weightsHeight, somWeights, somWidth, somHeight);
+        som->writeWeights(somWeights);
+      }
+      shouldWarmStartOnNextInstance = false;
+      lastPublished.clear();
+      qeAverage = -1.0f;
+      stableCount = 0;
+      idle.store(false);
+      publishPixels();
+      break;
+  }
+}
+
+void SomPalette::resetSom() {
+  level = 0;
+  completedLevelIterations = 0;
+  if (coarseToFine) {
+    setupCoarseToFineLevels();
+    setupSomAtSize(levelSizes[0].first, levelSizes[0].second, initialLearningRate, levelIterations[0]);
+  } else {
+    setupSomAtSize(width, height, initialLearningRate, numIterations);
+  }
   shouldWarmStartOnNextInstance = true;
+  idle.store(false);
 }
 
-void SomPalette::addInstanceData(SomInstanceDataT instanceData) {
-  if (isIterating()) newInstanceData.send(instanceData);
+void SomPalette::publishIterationCounts() {
+  currentIteration.store(completedLevelIterations + som->getCurrentIteration());
+  // Coarse-to-fine: the levels' sum, which only differs from numIterations when it was set too
+  // small to give every remaining level an iteration.
+  int totalIterations = som->getNumIterations();
+  if (coarseToFine) totalIterations = std::accumulate(levelIterations.begin(), levelIterations.end(), 0);
+  currentNumIterations.store(totalIterations);
+}
+
+bool SomPalette::takeInstance() {
+  const uint64_t consumed = consumedInstanceCount.fetch_add(1) + 1;
+  return consumed > discardThroughCount;
+}
+
+bool SomPalette::receiveInstance(SomInstanceDataT& instanceData, int64_t timeoutMillis) {
+  if (numSources.load(std::memory_order_acquire) == 0) {
+    return newInstanceData.tryReceive(instanceData, timeoutMillis) && takeInstance();
+  }
+  if (mergeSources(instanceData)) return true;
+
+  // Nothing queued anywhere: sleep until a push wakes us.
+  {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    isWorkerWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeCondition.wait_for(lock, std::chrono::milliseconds(timeoutMillis), [this] { return !isThreadRunning() || hasQueuedInstances(); });
+    isWorkerWaiting.store(false, std::memory_order_relaxed);
+  }
+  return mergeSources(instanceData);
+}
+
+void SomPalette::wakeWorker() {
+  // Pairs with the fence in receiveInstance: either the worker sees what was just queued before it
+  // sleeps, or we see that it is waiting and notify it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!isWorkerWaiting.load(std::memory_order_relaxed)) return;
+  std::lock_guard<std::mutex> lock(wakeMutex);
+  wakeCondition.notify_one();
+}
+
+bool SomPalette::hasQueuedInstances() const {
+  const int sourceCount = numSources.load(std::memory_order_acquire);
+  for (int i = 0; i < sourceCount; ++i) {
+    if (sourceLanes[i]->queue.sizeApprox() > 0) return true;
+  }
+  return !newInstanceData.empty();
+}
+
+bool SomPalette::mergeSources(SomInstanceDataT& instanceData) {
+  const int sourceCount = numSources.load(std::memory_order_acquire);
+  if (sourceCount == 0) return false;
+
+  // Stride scheduling: serve the backlogged lane with the lowest pass, then advance its pass by
+  // 1 / weight. A lane that was idle rejoins at the current pass rather than with banked credit.
+  for (;;) {
+    SourceLane* next = nullptr;
+    double nextPass = std::numeric_limits<double>::max();
+    for (int i = 0; i < sourceCount; ++i) {
+      SourceLane& lane = *sourceLanes[i];
+      if (lane.queue.sizeApprox() == 0) continue;
+      lane.pass = std::max(lane.pass, globalPass);
+      if (lane.pass < nextPass) {
+        next = &lane;
+        nextPass = lane.pass;
+      }
+    }
+    const bool isChannelBacklogged = !newInstanceData.empty();
+    if (isChannelBacklogged) channelPass = std::max(channelPass, globalPass);
+
+    if (isChannelBacklogged && channelPass < nextPass) {
+      globalPass = channelPass;
+      channelPass += 1.0;
+      if (!newInstanceData.tryReceive(instanceData)) return false;
+      if (takeInstance()) return true;
+      continue;
+    }
+    if (!next) return false;
+
+    next->queue.pop(instanceData);
+    globalPass = next->pass;
+    next->pass += 1.0 / std::max(next->weight.load(), 1e-3f);
+    const uint64_t consumed = next->consumed.fetch_add(1) + 1;
+    if (consumed > next->discardThroughCount) return true;
+  }
+}
+
+void SomPalette::setupCoarseToFineLevels() {
+  // Halve until the longer side fits coarsestSize, then list the levels coarsest first.
+  int numHalvings = 0;
+  while (std::max(width, height) >> numHalvings > coarsestSize) ++numHalvings;
+
+  levelSizes.clear();
+  for (int k = numHalvings; k >= 0; --k) {
+    const int div = 1 << k;
+    levelSizes.emplace_back(std::max(2, (width + div - 1) / div), std::max(2, (height + div - 1) / div));
+  }
+  levelSizes.back() = { width, height };
+
+  levelIterations.assign(levelSizes.size(), 1);
+  splitLevelIterations(0, numIterations);
+}
+
+void SomPalette::splitLevelIterations(size_t firstLevel, int budget) {
+  // Each level gets half the iterations of the one before it, so most of the budget is coarse.
+  const size_t numLevels = levelSizes.size() - firstLevel;
+  const float totalWeight = static_cast<float>((1 << numLevels) - 1);
+  int allocated = 0;
+  for (size_t l = 0; l + 1 < numLevels; ++l) {
+    const float weight = static_cast<float>(1 << (numLevels - 1 - l));
+    levelIterations[firstLevel + l] = std::max(1, static_cast<int>(budget * weight / totalWeight));
+    allocated += levelIterations[firstLevel + l];
+  }
+  levelIterations.back() = std::max(1, budget - allocated);
+}
+
+void SomPalette::advanceCoarseToFineLevel() {
+  std::vector<float> coarse, fine;
+  som->readWeights(coarse);
+  const int coarseWidth = somWidth;
+  const int coarseHeight = somHeight;
+
+  completedLevelIterations += som->getNumIterations();
+  ++level;
+
+  // Finer levels only refine an already-ordered map, so they start with a gentler learning rate.
+  const float learningRate = initialLearningRate / static_cast<float>(1 << level);
+  setupSomAtSize(levelSizes[level].first, levelSizes[level].second, learningRate, levelIterations[level]);
+
+  resampleWeights(coarse, coarseWidth, coarseHeight, fine, somWidth, somHeight);
+  som->writeWeights(fine);
+}
+
+void SomPalette::warmStartFromFirstInstance(float mix) {
+  WorkerCommand command;
+  command.type = WorkerCommand::Type::WarmStart;
+  command.mix = mix;
+  postCommand(std::move(command));
+}
+
+bool SomPalette::addInstanceData(SomInstanceDataT instanceData) {
+  if (!isIterating() || !newInstanceData.send(instanceData)) return false;
+  queuedInstanceCount.fetch_add(1);
+  wakeWorker();
+  return true;
+}
+
+SomPalette::SourceLane::SourceLane(float weight_, double maxRatePerSecond_, size_t queueCapacity) :
+queue { queueCapacity },
+weight { weight_ },
+maxRatePerSecond { maxRatePerSecond_ },
+burstSize { std::max(1.0, maxRatePerSecond_ * 0.1) },
+tokens { burstSize }
+{}
+
+int SomPalette::registerSource(float weight, double maxRatePerSecond, size_t queueCapacity) {
+  std::lock_guard<std::mutex> lock(sourceRegistrationMutex);
+  const int sourceId = numSources.load();
+  if (sourceId >= maxSources) {
+    ofLogWarning("SomPalette") << "registerSource: already have " << maxSources << " sources";
+    return -1;
+  }
+  sourceLanes[sourceId] = std::make_unique<SourceLane>(weight, maxRatePerSecond, queueCapacity);
+  numSources.store(sourceId + 1, std::memory_order_release);
+  return sourceId;
+}
+
+void SomPalette::setSourceWeight(int sourceId, float weight) {
+  if (sourceId < 0 || sourceId >= numSources.load()) return;
+  sourceLanes[sourceId]->weight.store(weight);
+}
+
+bool SomPalette::addInstanceData(int sourceId, const SomInstanceDataT& instanceData) {
+  if (sourceId < 0 || sourceId >= numSources.load(std::memory_order_acquire)) return false;
+  if (!isIterating()) return false;
+  SourceLane& lane = *sourceLanes[sourceId];
+
+  if (lane.maxRatePerSecond > 0.0) {
+    const uint64_t nowMicros = ofGetElapsedTimeMicros();
+    if (lane.lastRefillMicros != 0) {
+      lane.tokens = std::min(lane.burstSize, lane.tokens + (nowMicros - lane.lastRefillMicros) * 1e-6 * lane.maxRatePerSecond);
+    }
+    lane.lastRefillMicros = nowMicros;
+    if (lane.tokens < 1.0) {
+      lane.rateLimited.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    lane.tokens -= 1.0;
+  }
+
+  if (!lane.queue.push(instanceData)) {
+    lane.dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  lane.accepted.fetch_add(1, std::memory_order_relaxed);
+  wakeWorker();
+  return true;
+}
+
+SomSourceStats SomPalette::getSourceStats(int sourceId) const {
+  SomSourceStats stats;
+  if (sourceId < 0 || sourceId >= numSources.load(std::memory_order_acquire)) return stats;
+  const SourceLane& lane = *sourceLanes[sourceId];
+  stats.accepted = lane.accepted.load();
+  stats.rateLimited = lane.rateLimited.load();
+  stats.dropped = lane.dropped.load();
+  stats.consumed = lane.consumed.load();
+  return stats;
+}
+
+uint64_t SomPalette::getQueuedInstanceCount() const {
+  uint64_t count = queuedInstanceCount.load();
+  const int sourceCount = numSources.load(std::memory_order_acquire);
+  for (int i = 0; i < sourceCount; ++i) count += sourceLanes[i]->accepted.load();
+  return count;
+}
+
+uint64_t SomPalette::getConsumedInstanceCount() const {
+  uint64_t count = consumedInstanceCount.load();
+  const int sourceCount = numSources.load(std::memory_order_acquire);
+  for (int i = 0; i < sourceCount; ++i) count += sourceLanes[i]->consumed.load();
+  return count;
+}
+
+uint64_t SomPalette::getQueueDepth() const {
+  // Consumed first: both only grow, so queued then can only have caught up, never fallen behind.
+  const uint64_t consumed = getConsumedInstanceCount();
+  const uint64_t queued = getQueuedInstanceCount();
+  return (queued > consumed) ? queued - consumed : 0;
+}
+
+void SomPalette::setIdleDetection(bool enabled, float stabilityThreshold, int stableInstances, float noveltyRatio, bool stopTrainingWhenIdle) {
+  idleStabilityThreshold.store(stabilityThreshold);
+  idleStableInstances.store(std::max(1, stableInstances));
+  idleNoveltyRatio.store(noveltyRatio);
+  idleStopsTraining.store(stopTrainingWhenIdle);
+  idleDetectionEnabled.store(enabled);
+  if (!enabled) idle.store(false);
+}
+
+void SomPalette::setWorkerSettings(const SomWorkerSettings& settings) {
+  std::lock_guard<std::mutex> lock(workerSettingsMutex);
+  workerSettings = settings;
+  workerSettingsChanged.store(true);
+}
+
+SomWorkerStatus SomPalette::getWorkerStatus() const {
+  SomWorkerStatus status;
+  {
+    std::lock_guard<std::mutex> lock(workerSettingsMutex);
+    status = workerStatus;
+  }
+  status.deferredPublishes = deferredPublishes.load();
+  status.decimatedInstances = decimatedInstances.load();
+  return status;
 }
 
 void SomPalette::setColorizerGains(float grayGain, float chromaGain) {
-  colorizerGrayGain.store(grayGain);
-  colorizerChromaGain.store(chromaGain);
+  WorkerCommand command;
+  command.type = WorkerCommand::Type::SetColorizerGains;
+  command.grayGain = grayGain;
+  command.chromaGain = chromaGain;
+  postCommand(std::move(command));
+}
+
+void SomPalette::setColorizer(const SomColorizer& colorizer_) {
+  WorkerCommand command;
+  command.type = WorkerCommand::Type::SetColorizer;
+  command.colorizer = colorizer_;
+  postCommand(std::move(command));
+}
+
+void SomPalette::warmStartWeights(std::vector<float>& weights, int w, int h, const SomInstanceDataT& instanceData, float mix) {
+  const float invMix = 1.0f - mix;
+
+  // Preserve per-cell variation so the palette doesn't collapse to a single color.
+  // We bias the map toward the first observed instance, but keep a small, deterministic jitter.
+  const float noiseAmp = 0.08f * invMix;
+
+  for (int i = 0; i < w; i++) {
+    for (int j = 0; j < h; j++) {
+      float* c = &weights[(j * w + i) * 3];
+
+      // Simple coordinate hash -> [0..1)
+      uint32_t hash = static_cast<uint32_t>(i * 73856093) ^ static_cast<uint32_t>(j * 19349663);
+
+      for (int z = 0; z < 3; z++) {
+        hash ^= static_cast<uint32_t>((z + 1) * 83492791);
+        hash *= 1664525u;
+        hash += 1013904223u;
+
+        const float n01 = static_cast<float>(hash) / static_cast<float>(std::numeric_limits<uint32_t>::max());
+        const float n = (n01 * 2.0f - 1.0f) * noiseAmp;
+
+        const float target = ofClamp(static_cast<float>(instanceData[z]) + n, 0.0f, 1.0f);
+        c[z] = ofClamp(invMix * c[z] + mix * target, 0.0f, 1.0f);
+      }
+    }
+  }
+}
+
+ofFloatColor SomPalette::colorizeFeatures(float f0, float f1, float f2, float grayGain, float chromaGain) {
+  // Feature-space -> RGB colorization.
+  // Features are expected in [0..1]:
+  //   f0 = centroid, f1 = crest, f2 = zcr
+  // Centroid contributes equally to RGB (brightness), while crest/zcr contribute to chroma.
+  const float x0 = f0 - 0.5f;
+  const float x1 = f1 - 0.5f;
+  const float x2 = f2 - 0.5f;
+
+  const float gray = grayGain * x0;
+
+  // Chroma plane from (crest, zcr). Instead of mapping chroma mostly into R/G and leaving B
+  // to follow brightness, spread chroma across RGB so "blue" can actually occur.
+  const float u = chromaGain * x1;
+  // Invert zcr axis so higher zcr can contribute "blue".
+  const float v = chromaGain * -x2;
+
+  // 120-degree rotation basis (u,v) -> (r,g,b) with zero-sum chroma.
+  constexpr float SQRT3_OVER_2 = 0.8660254037844386f;
+  const float r = ofClamp(0.5f + gray + u, 0.0f, 1.0f);
+  const float g = ofClamp(0.5f + gray - 0.5f * u + SQRT3_OVER_2 * v, 0.0f, 1.0f);
+  const float b = ofClamp(0.5f + gray - 0.5f * u - SQRT3_OVER_2 * v, 0.0f, 1.0f);
+
+  return ofFloatColor(r, g, b);
 }
 
 // TODO: Make sure we can't be overwhelmed if producer fills queue faster than we consume (e.g. could just do the SOM not the pixels)
 void SomPalette::threadedFunction() {
+  SOM_PALETTE_TRACE_THREAD_NAME(getThreadName());
+
   SomInstanceDataT instanceData;
-  
-  while (newInstanceData.receive(instanceData)) {
-    if (shouldWarmStartOnNextInstance) {
-      const float mix = warmStartMix.load();
-      const float invMix = 1.0f - mix;
+  while (isThreadRunning()) {
+    applyPendingWorkerSettings();
+    processCommands();
+
+    if (trainingBudgetMillis <= 0.0f) {
+      // Unlimited: train and publish every instance as it arrives.
+      if (!receiveInstance(instanceData, commandPollMillis)) continue;
+      if (trainInstance(instanceData)) publishPixels();
+      continue;
+    }
 
-      // Preserve per-cell variation so the palette doesn't collapse to a single color.
-      // We bias the map toward the first observed instance, but keep a small, deterministic jitter.
-      const float noiseAmp = 0.08f * invMix;
+    // Budgeted: once a tick's budget is spent, drop instances until the next tick,
+    // and publish at most once per tick.
+    const uint64_t nowMicros = ofGetElapsedTimeMicros();
+    const uint64_t tickMicros = static_cast<uint64_t>(tickMillis * 1000.0f);
+    if (nowMicros - tickStartMicros >= tickMicros) {
+      tickStartMicros = nowMicros;
+      tickSpentMicros = 0;
+      if (isPublishPending) {
+        publishPixels();
+        isPublishPending = false;
+        tickSpentMicros = ofGetElapsedTimeMicros() - nowMicros;
+      }
+    }
 
-      for (int i = 0; i < width; i++) {
-        for (int j = 0; j < height; j++) {
-          double* c = som.getMapAt(i, j);
+    const int64_t remainingMillis = std::max<int64_t>(1, static_cast<int64_t>(tickStartMicros + tickMicros - nowMicros) / 1000);
+    if (!receiveInstance(instanceData, std::min(remainingMillis, commandPollMillis))) continue;
 
-          // Simple coordinate hash -> [0..1)
-          uint32_t h = static_cast<uint32_t>(i * 73856093) ^ static_cast<uint32_t>(j * 19349663);
+    if (tickSpentMicros >= static_cast<uint64_t>(trainingBudgetMillis * 1000.0f)) {
+      decimatedInstances.fetch_add(1);
+      continue;
+    }
 
-          for (int z = 0; z < 3; z++) {
-            h ^= static_cast<uint32_t>((z + 1) * 83492791);
-            h *= 1664525u;
-            h += 1013904223u;
+    const uint64_t startMicros = ofGetElapsedTimeMicros();
+    if (trainInstance(instanceData)) {
+      if (isPublishPending) deferredPublishes.fetch_add(1);
+      isPublishPending = true;
+    }
+    tickSpentMicros += ofGetElapsedTimeMicros() - startMicros;
+  }
+}
 
-            const float n01 = static_cast<float>(h) / static_cast<float>(std::numeric_limits<uint32_t>::max());
-            const float n = (n01 * 2.0f - 1.0f) * noiseAmp;
+void SomPalette::applyPendingWorkerSettings() {
+  if (!workerSettingsChanged.exchange(false)) return;
 
-            const float target = ofClamp(static_cast<float>(instanceData[z]) + n, 0.0f, 1.0f);
-            c[z] = ofClamp(static_cast<float>(invMix * c[z] + mix * target), 0.0f, 1.0f);
-          }
-        }
-      }
-      shouldWarmStartOnNextInstance = false;
+  SomWorkerSettings settings;
+  {
+    std::lock_guard<std::mutex> lock(workerSettingsMutex);
+    settings = workerSettings;
+  }
+  trainingBudgetMillis = settings.trainingBudgetMillis;
+  tickMillis = std::max(1.0f, settings.tickMillis);
+  tickStartMicros = ofGetElapsedTimeMicros();
+  tickSpentMicros = 0;
+
+  const SomWorkerStatus status = applySomWorkerSettings(settings);
+  if (!status.error.empty()) {
+    ofLogWarning("SomPalette") << "worker settings partly applied: " << status.error;
+  }
+  std::lock_guard<std::mutex> lock(workerSettingsMutex);
+  workerStatus = status;
+}
+
+bool SomPalette::trainInstance(const SomInstanceDataT& instanceData) {
+  constexpr float emaRate = 0.05f;
+  constexpr float noveltyFloor = 0.02f; // stops tiny jitter waking a map converged on a sustained note
+
+  const bool detectIdle = idleDetectionEnabled.load();
+
+  if (shouldWarmStartOnNextInstance) {
+    SOM_PALETTE_TRACE_ZONE("SomPalette::warmStart");
+    lastPublished.clear();
+    qeAverage = -1.0f;
+    deltaAverage = 1.0f;
+    stableCount = 0;
+
+    som->readWeights(somWeights);
+    warmStartWeights(somWeights, somWidth, somHeight, instanceData, warmStartMix);
+    som->writeWeights(somWeights);
+    shouldWarmStartOnNextInstance = false;
+  }
+
+  auto updateMap = [&] {
+    SOM_PALETTE_TRACE_ZONE("SomPalette::updateMap");
+    return som->updateMap(instanceData);
+  };
+  auto trackQuantizationError = [&](float qe) {
+    if (idle.load() && qeAverage >= 0.0f && qe > std::max(noveltyFloor, qeAverage * idleNoveltyRatio.load())) {
+      // Novel input: start publishing again.
+      idle.store(false);
+      stableCount = 0;
     }
+    qeAverage = (qeAverage < 0.0f) ? qe : qeAverage + emaRate * (qe - qeAverage);
+    quantizationError.store(qeAverage);
+  };
 
-    som.updateMap(instanceData.data());
-    
-    ofFloatPixels pixels;
-    pixels.allocate(width, height, OF_IMAGE_COLOR);
-    
-    const float grayGain = colorizerGrayGain.load();
-    const float chromaGain = colorizerChromaGain.load();
-
-    for (int i = 0; i < width; i++) {
-      for (int j = 0; j < height; j++) {
-        double* c = som.getMapAt(i, j);
-
-        // Feature-space -> RGB colorization.
-        // Features are expected in [0..1]:
-        //   f0 = centroid, f1 = crest, f2 = zcr
-        // Centroid contributes equally to RGB (brightness), while crest/zcr contribute to chroma.
-        const float x0 = static_cast<float>(c[0]) - 0.5f;
-        const float x1 = static_cast<float>(c[1]) - 0.5f;
-        const float x2 = static_cast<float>(c[2]) - 0.5f;
-
-        const float gray = grayGain * x0;
-
-        // Chroma plane from (crest, zcr). Instead of mapping chroma mostly into R/G and leaving B
-        // to follow brightness, spread chroma across RGB so "blue" can actually occur.
-        const float u = chromaGain * x1;
-        // Invert zcr axis so higher zcr can contribute "blue".
-        const float v = chromaGain * -x2;
-
-        // 120-degree rotation basis (u,v) -> (r,g,b) with zero-sum chroma.
-        constexpr float SQRT3_OVER_2 = 0.8660254037844386f;
-        const float r = ofClamp(0.5f + gray + u, 0.0f, 1.0f);
-        const float g = ofClamp(0.5f + gray - 0.5f * u + SQRT3_OVER_2 * v, 0.0f, 1.0f);
-        const float b = ofClamp(0.5f + gray - 0.5f * u - SQRT3_OVER_2 * v, 0.0f, 1.0f);
-
-        ofFloatColor col(r, g, b);
-        pixels.setColor(i, j, col);
-      }
+  if (!detectIdle) {
+    updateMap();
+  } else if (idle.load() && idleStopsTraining.load()) {
+    // Not training, so searching for the quantization error is the only per-instance cost.
+    trackQuantizationError(som->findQuantizationError(instanceData));
+    if (idle.load()) return false;
+    updateMap();
+  } else {
+    // The update's best matching cell gives the error for free. Checking novelty after the
+    // update rather than before makes no difference to which instances are trained.
+    trackQuantizationError(updateMap());
+  }
+  const bool isIdleNow = detectIdle && idle.load();
+
+  if (coarseToFine && level + 1 < levelSizes.size() && som->getCurrentIteration() >= som->getNumIterations()) {
+    SOM_PALETTE_TRACE_ZONE("SomPalette::advanceCoarseToFineLevel");
+    advanceCoarseToFineLevel();
+  }
+  publishIterationCounts();
+
+  return !isIdleNow;
+}
+
+void SomPalette::publishPixels() {
+  SOM_PALETTE_TRACE_ZONE("SomPalette::colorize");
+  constexpr float emaRate = 0.05f;
+
+  PaletteFrame frame;
+  frame.instanceCount = getConsumedInstanceCount();
+  frame.generation = workerGeneration;
+  ofFloatPixels& pixels = frame.pixels;
+  pixels.allocate(width, height, OF_IMAGE_COLOR);
+
+  som->readWeights(somWeights);
+  const std::vector<float>* weights = &somWeights;
+  if (somWidth != width || somHeight != height) {
+    // Coarse level: show the coarse map stretched over the full output size.
+    resampleWeights(somWeights, somWidth, somHeight, fullWeights, width, height);
+    weights = &fullWeights;
+  }
+  // Weights and pixels share the packed row-major layout, so this is one pass over the buffer.
+  colorizer.colorize(weights->data(), pixels.getData(), static_cast<size_t>(width) * static_cast<size_t>(height));
+
+  const bool detectIdle = idleDetectionEnabled.load();
+  if (detectIdle) {
+    const float* p = pixels.getData();
+    const size_t n = static_cast<size_t>(width) * static_cast<size_t>(height) * 3;
+    if (lastPublished.size() == n) {
+      float sum = 0.0f;
+      for (size_t k = 0; k < n; ++k) sum += std::abs(p[k] - lastPublished[k]);
+      const float delta = sum / static_cast<float>(n);
+      deltaAverage += emaRate * (delta - deltaAverage);
+      pixelDelta.store(deltaAverage);
+      stableCount = (delta < idleStabilityThreshold.load()) ? stableCount + 1 : 0;
     }
-    
-    newPalettePixels.send(std::move(pixels));
+    lastPublished.assign(p, p + n);
+  }
+  
+  {
+    SOM_PALETTE_TRACE_ZONE("SomPalette::sendPixels");
+    newPalettePixels.send(std::move(frame));
+  }
+  publishedFrameCount.fetch_add(1);
+
+  // Go idle only after publishing, so the last frame shown is the settled one.
+  if (detectIdle && stableCount >= idleStableInstances.load()) {
+    idle.store(true);
   }
 }
 
@@ -157,11 +760,17 @@ void SomPalette::threadedFunction() {
 // .......
 // X..X..X
 void SomPalette::updatePalette() {
-  // Pick the most-separated colors from the SOM field, then sort by lightness.
-  // This gives a more varied palette than fixed edge sampling.
+  SOM_PALETTE_TRACE_ZONE("SomPalette::updatePalette");
   const int w = pixels.getWidth();
   const int h = pixels.getHeight();
   if (w <= 0 || h <= 0) return;
+  extractPalette(pixels.getData(), static_cast<size_t>(w) * static_cast<size_t>(h), palette);
+}
+
+void SomPalette::extractPalette(const float* rgb, size_t numCells, std::array<ofColor, size>& paletteOut) {
+  // Pick the most-separated colors from the SOM field, then sort by lightness.
+  // This gives a more varied palette than fixed edge sampling.
+  if (numCells == 0) return;
 
   auto lightness = [](const ofFloatColor& c) {
     // Approximate lightness in [0..1]
@@ -176,12 +785,10 @@ void SomPalette::updatePalette() {
   };
 
   std::vector<ofFloatColor> candidates;
-  candidates.reserve(static_cast<size_t>(w) * static_cast<size_t>(h));
+  candidates.reserve(numCells);
 
-  for (int y = 0; y < h; ++y) {
-    for (int x = 0; x < w; ++x) {
-      candidates.push_back(pixels.getColor(x, y));
-    }
+  for (size_t i = 0; i < numCells; ++i) {
+    candidates.emplace_back(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
   }
 
   // Seed with darkest + lightest.
@@ -236,28 +843,55 @@ void SomPalette::updatePalette() {
   }
 
   for (size_t i = 0; i < size; ++i) {
-    palette[i] = selected[i];
+    paletteOut[i] = selected[i];
   }
 
-  std::sort(palette.begin(), palette.end(), [](ofColor a, ofColor b) { return a.getLightness() < b.getLightness(); });
+  std::sort(paletteOut.begin(), paletteOut.end(), [](ofColor a, ofColor b) { return a.getLightness() < b.getLightness(); });
 }
 
 void SomPalette::update() {
+  flushOverflowCommands();
   isNewPalettePixelsReady = false;
-  while (newPalettePixels.tryReceive(pixels)) {
+  // Nothing published since last time (e.g. idle): skip the channel, texture and palette work.
+  const uint64_t published = publishedFrameCount.load();
+  if (published == receivedFrameCount) return;
+  receivedFrameCount = published;
+
+  SOM_PALETTE_TRACE_ZONE("SomPalette::update");
+
+  PaletteFrame frame, received;
+  while (newPalettePixels.tryReceive(received)) {
+    if (received.generation != generation) continue; // trained before the last reset()
+    frame = std::move(received);
     isNewPalettePixelsReady = true;
   }
   if (isNewPalettePixelsReady) {
+    pixels = std::move(frame.pixels);
+    visibleInstanceCount = frame.instanceCount;
     if (!paletteTexture.isAllocated()) {
       paletteTexture.allocate(pixels, false);
       paletteTexture.setTextureMinMagFilter(GL_LINEAR, GL_LINEAR); // for interpolation when sampling
       paletteTexture.setTextureWrap(GL_MIRRORED_REPEAT, GL_MIRRORED_REPEAT); // for wrapping when sampling
     }
-    paletteTexture.loadData(pixels);
+    {
+      SOM_PALETTE_TRACE_ZONE("SomPalette::textureUpload");
+      paletteTexture.loadData(pixels);
+    }
     updatePalette();
+    for (auto& sink : sinks) {
+      sink->publish(pixels, palette);
+    }
   }
 }
 
+void SomPalette::addSink(std::shared_ptr<SomPaletteSink> sink) {
+  if (sink) sinks.push_back(std::move(sink));
+}
+
+void SomPalette::removeSink(const std::shared_ptr<SomPaletteSink>& sink) {
+  sinks.erase(std::remove(sinks.begin(), sinks.end(), sink), sinks.end());
+}
+
 bool SomPalette::keyPressed(int key) {
   std::string timestamp = ofGetTimestampString();
   if (key == 'U' && paletteTexture.isAllocated()) {
@@ -310,3 +944,16 @@ ofColor SomPalette::getColorAt(int x, int y) const {
   if (!paletteTexture.isAllocated()) return ofColor::black;
   return pixels.getColor(x, y);
 }
+
+void SomPalette::getColorsAt(const glm::vec2* uvs, ofFloatColor* colorsOut, size_t count) const {
+  if (!paletteTexture.isAllocated()) {
+    std::fill(colorsOut, colorsOut + count, ofFloatColor(0.0f, 0.0f, 0.0f));
+    return;
+  }
+  sampleBilinearMirrored(pixels, uvs, colorsOut, count);
+}
+
+void SomPalette::getColorsAt(const std::vector<glm::vec2>& uvs, std::vector<ofFloatColor>& colorsOut) const {
+  colorsOut.resize(uvs.size());
+  getColorsAt(uvs.data(), colorsOut.data(), uvs.size());
+}
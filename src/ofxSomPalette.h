@@ -2,23 +2,53 @@
 
 #include <array>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "ofMain.h"
-#include "ofxSelfOrganizingMap.h"
+#include "ofxSomBackend.h"
+#include "ofxSomColorizer.h"
+#include "ofxSomPaletteSink.h"
+#include "ofxSomRingBuffer.h"
+#include "ofxSomWorkerSettings.h"
 
-// The doubles need to be normalised 0.0..1.0
-using SomInstanceDataT = std::array<double, 3>;
+// Per-source ingest counters (see SomPalette::registerSource).
+struct SomSourceStats {
+  uint64_t accepted { 0 }; // queued for the worker
+  uint64_t rateLimited { 0 }; // rejected by the source's rate limit
+  uint64_t dropped { 0 }; // rejected because the source's queue was full
+  uint64_t consumed { 0 }; // taken by the worker
+};
 
+// Control calls (reset, setupSom, setNumIterations, warmStartFromFirstInstance, setColorizerGains,
+// setColorizer, setCoarseToFine, setBackend, loadState) are main-thread only. They never block: each posts a
+// command that the worker applies, in order, before its next instance. Iteration counts are what
+// the worker last published, so they catch up once it has applied the command.
 class SomPalette: public ofThread {
 
 public:
   SomPalette(int width_=16, int height_=16, float initialLearningRate_=0.01, int numIterations_=5000);
   ~SomPalette();
-  void setupSom(float initialLearningRate, int numIterations);
+  void setupSom(float initialLearningRate, int numIterations); // resets the map
   void reset();
   void warmStartFromFirstInstance(float mix = 0.85f);
-  bool isIterating() { return som.getCurrentIteration() < som.getNumIterations(); }
-  void addInstanceData(SomInstanceDataT instanceData);
+  bool isIterating() const { return getCurrentIteration() < getNumIterations(); }
+  bool addInstanceData(SomInstanceDataT instanceData); // false if not queued (e.g. training finished)
+
+  // Multi-producer ingestion. Each registered source gets its own lock-free queue, so several
+  // real-time threads (microphones, MIDI...) can push without contending with each other.
+  // When the worker can't keep up, backlogged sources are served in proportion to their weights;
+  // maxRatePerSecond (0 = unlimited) caps what a source can queue, allowing bursts of up to 100ms
+  // worth. Register from the main thread; each source id must then be fed from one thread only.
+  // Returns -1 once maxSources are registered.
+  static constexpr int maxSources = 16;
+  int registerSource(float weight = 1.0f, double maxRatePerSecond = 0.0, size_t queueCapacity = 256);
+  void setSourceWeight(int sourceId, float weight);
+  bool addInstanceData(int sourceId, const SomInstanceDataT& instanceData); // false if not queued
+  SomSourceStats getSourceStats(int sourceId) const;
   void update(); // move pixels into a GL texture on main thread
   bool keyPressed(int key);
 
@@ -26,44 +56,245 @@ public:
   // grayGain: centroid -> brightness contribution
   // chromaGain: crest/zcr -> chroma contribution
   void setColorizerGains(float grayGain, float chromaGain);
+  // Replaces the whole mapping, e.g. with a user matrix or 3-D LUT (see SomColorizer).
+  void setColorizer(const SomColorizer& colorizer);
   void draw(bool forceVisible = false, bool paletteOnly = false);
   const ofFloatPixels& getPixelsRef() const { return pixels; }
+  bool hasNewPixels() const { return isNewPalettePixelsReady; } // whether the last update() received a frame
   const ofTexture& getTexture() const { return paletteTexture; }
   ofColor getColorAt(int x, int y) const;
+  // Batch bilinear + mirrored-wrap sampling at normalized UVs, matching the texture's GL sampling.
+  void getColorsAt(const glm::vec2* uvs, ofFloatColor* colorsOut, size_t count) const;
+  void getColorsAt(const std::vector<glm::vec2>& uvs, std::vector<ofFloatColor>& colorsOut) const;
   ofColor getColor(int i) const { return palette[i]; }
   bool isVisible() const { return visible; };
   void setVisible(bool visible_) { visible = visible_; };
-  int getCurrentIteration() { return som.getCurrentIteration(); };
-  int getNumIterations() { return som.getNumIterations(); };
-  void setNumIterations(int numIterations_) { som.setNumIterations(numIterations_); };
+  int getCurrentIteration() const { return currentIteration.load(); };
+  int getNumIterations() const { return currentNumIterations.load(); };
+  void setNumIterations(int numIterations_);
+
+  // Replaces the map's weights, e.g. with a map saved from an earlier run. Packed 3-feature floats
+  // in [0..1], row-major: weights[(j * weightsWidth + i) * 3 + feature]. Resampled to the current
+  // SOM size if needed. Cancels any pending warm start.
+  void loadState(std::vector<float> weights, int weightsWidth, int weightsHeight);
+
+  // Coarse-to-fine training: start on a small map (coarsestSize on its longer side), then repeatedly
+  // double it, initialising each level by upsampling the previous one, until width x height.
+  // Coarse levels are cheap and order quickly, so they get most of the numIterations budget.
+  // Output pixels are always width x height (coarse levels are upsampled for display).
+  // Takes effect immediately by resetting the map.
+  void setCoarseToFine(bool enabled, int coarsestSize = 4);
+  bool isCoarseToFine() const { return requestedCoarseToFine; }
+
+  // SOM implementation: the double-precision ofxSelfOrganizingMap (default), or 16/8-bit
+  // fixed point for low-power boards (see SomFixedPointBackend). Takes effect immediately by
+  // resetting the map.
+  void setBackend(SomBackendType type);
+  SomBackendType getBackend() const { return requestedBackendType; }
+
+  // Idle detection: once published frames stop changing (mean per-channel delta below
+  // stabilityThreshold for stableInstances consecutive instances) the worker stops colorizing and
+  // publishing, and optionally stops training. An instance whose quantization error exceeds
+  // noveltyRatio x the running average wakes it up again.
+  void setIdleDetection(bool enabled, float stabilityThreshold = 0.002f, int stableInstances = 60, float noveltyRatio = 2.5f, bool stopTrainingWhenIdle = false);
+  bool isIdle() const { return idle.load(); }
+  float getQuantizationError() const { return quantizationError.load(); } // running average
+  float getPixelDelta() const { return pixelDelta.load(); } // running average of mean per-channel change between published frames
+
+  // Worker scheduling policy, nice level, CPU affinity and training budget. Applied by the worker
+  // the next time it wakes; getWorkerStatus() reports what actually took effect.
+  void setWorkerSettings(const SomWorkerSettings& settings);
+  SomWorkerStatus getWorkerStatus() const;
+
+  // Instrumentation for latency/soak testing.
+  // Queued: accepted by addInstanceData (from any source). Consumed: taken off the queue by the worker (trained,
+  // skipped while idle, or dropped by the budget). Visible: consumed count as of the pixels
+  // currently held by the main thread (i.e. after the last update()).
+  uint64_t getQueuedInstanceCount() const;
+  uint64_t getConsumedInstanceCount() const;
+  uint64_t getVisibleInstanceCount() const { return visibleInstanceCount; }
+  // Never negative, but approximate while producers are active: they count an instance only after
+  // queueing it, so the worker can consume it first.
+  uint64_t getQueueDepth() const;
   static constexpr size_t size = 8;
 
+  // Sinks receive every new snapshot from update(), e.g. SomPaletteSharedMemoryPublisher.
+  void addSink(std::shared_ptr<SomPaletteSink> sink);
+  void removeSink(const std::shared_ptr<SomPaletteSink>& sink);
+
+  // The built-in mapping for a single [0..1] feature vector (centroid, crest, zcr) to RGB.
+  // Whole buffers go through SomColorizer, which gives the same result with the gain matrix.
+  static ofFloatColor colorizeFeatures(float f0, float f1, float f2, float grayGain, float chromaGain);
+  // Picks `size` well-separated colours from a packed RGB float field, sorted by lightness.
+  static void extractPalette(const float* rgb, size_t numCells, std::array<ofColor, size>& paletteOut);
+  // Pulls a packed w x h weight grid towards the first instance (mix), keeping a deterministic
+  // per-cell jitter so the palette doesn't collapse to one colour.
+  static void warmStartWeights(std::vector<float>& weights, int w, int h, const SomInstanceDataT& instanceData, float mix);
+
 protected:
   void threadedFunction() override;
 
 private:
   int width, height;
+
+  // Main-thread view of settings owned by the worker
+  bool requestedCoarseToFine { false };
+  SomBackendType requestedBackendType { SomBackendType::Float };
+
+  // Main thread -> worker control commands, applied in order between instances.
+  struct WorkerCommand {
+    enum class Type { Reset, Setup, SetNumIterations, SetCoarseToFine, SetBackend, WarmStart, SetColorizerGains, SetColorizer, LoadState };
+    Type type { Type::Reset };
+    uint64_t generation { 0 }; // Reset
+    uint64_t discardThroughCount { 0 }; // Reset: instances queued before it are dropped
+    std::array<uint64_t, maxSources> sourceDiscardThroughCounts {}; // Reset: the same, per source
+    float initialLearningRate { 0.0f }; // Setup
+    int numIterations { 0 }; // Setup, SetNumIterations
+    bool enabled { false }; // SetCoarseToFine
+    int coarsestSize { 4 }; // SetCoarseToFine
+    SomBackendType backendType { SomBackendType::Float }; // SetBackend
+    float mix { 0.0f }; // WarmStart
+    float grayGain { 0.0f }, chromaGain { 0.0f }; // SetColorizerGains
+    SomColorizer colorizer; // SetColorizer
+    std::vector<float> weights; // LoadState
+    int weightsWidth { 0 }, weightsHeight { 0 }; // LoadState
+  };
+  SomRingBuffer<WorkerCommand> commands { 64 };
+  std::deque<WorkerCommand> overflowCommands; // main thread only; holds commands while the ring is full
+  uint64_t generation { 0 }; // main thread's reset count; update() drops frames from before the last reset
+
+  // Published by the worker for the main thread
+  std::atomic<int> currentIteration { 0 };
+  std::atomic<int> currentNumIterations { 0 };
+
+  // Worker-owned SOM state
   float initialLearningRate;
   int numIterations;
+  SomBackendType backendType { SomBackendType::Float };
+  std::unique_ptr<SomBackend> som;
+  int somWidth, somHeight; // current SOM size; smaller than width x height at coarse levels
 
-  ofxSelfOrganizingMap som;
+  // Coarse-to-fine schedule, coarsest level first
+  bool coarseToFine { false };
+  int coarsestSize { 4 };
+  std::vector<std::pair<int, int>> levelSizes;
+  std::vector<int> levelIterations;
+  size_t level { 0 };
+  int completedLevelIterations { 0 };
 
   ofThreadChannel<SomInstanceDataT> newInstanceData;
-  ofThreadChannel<ofFloatPixels> newPalettePixels;
-  bool isNewPalettePixelsReady;
+  // Published pixels, tagged with how many instances the worker had consumed when colorizing them.
+  struct PaletteFrame {
+    ofFloatPixels pixels;
+    uint64_t instanceCount { 0 };
+    uint64_t generation { 0 };
+  };
+  ofThreadChannel<PaletteFrame> newPalettePixels;
+  bool isNewPalettePixelsReady { false };
 
   ofFloatPixels pixels; // the pixels that are moved to the GL texture
   ofTexture paletteTexture; // GL texture for the palette
   
   // Fixed as an 8-color palette
   std::array<ofColor, size> palette;
+  static_assert(std::tuple_size<SomPaletteColorsT>::value == size, "sinks receive the full palette");
+
+  std::vector<std::shared_ptr<SomPaletteSink>> sinks;
+
 
-  std::atomic<float> colorizerGrayGain { 1.0f };
-  std::atomic<float> colorizerChromaGain { 1.25f };
-  std::atomic<float> warmStartMix { 0.60f };
+  // Idle detection settings (main thread writes, worker reads) and published state
+  std::atomic<bool> idleDetectionEnabled { false };
+  std::atomic<float> idleStabilityThreshold { 0.002f };
+  std::atomic<int> idleStableInstances { 60 };
+  std::atomic<float> idleNoveltyRatio { 2.5f };
+  std::atomic<bool> idleStopsTraining { false };
+  std::atomic<bool> idle { false };
+  std::atomic<float> quantizationError { 0.0f };
+  std::atomic<float> pixelDelta { 0.0f };
+
+  // Worker settings handoff
+  mutable std::mutex workerSettingsMutex;
+  SomWorkerSettings workerSettings;
+  SomWorkerStatus workerStatus;
+  std::atomic<bool> workerSettingsChanged { false };
+  std::atomic<uint64_t> deferredPublishes { 0 };
+  std::atomic<uint64_t> decimatedInstances { 0 };
+
+  // Worker-only state
+  uint64_t workerGeneration { 0 };
+  uint64_t discardThroughCount { 0 };
+  SomColorizer colorizer;
+  float warmStartMix { 0.60f };
   bool shouldWarmStartOnNextInstance { true };
+  float trainingBudgetMillis { 0.0f };
+  float tickMillis { 16.0f };
+  uint64_t tickStartMicros { 0 };
+  uint64_t tickSpentMicros { 0 };
+  bool isPublishPending { false };
+  std::vector<float> somWeights, fullWeights; // scratch: SOM-sized, output-sized
+  std::vector<float> lastPublished;
+  float qeAverage { -1.0f };
+  float deltaAverage { 1.0f };
+  int stableCount { 0 };
+
+  // Counts for the shared newInstanceData channel; sources keep their own.
+  std::atomic<uint64_t> queuedInstanceCount { 0 };
+  std::atomic<uint64_t> consumedInstanceCount { 0 };
+
+  // One SPSC lane per registered source. Lanes are never removed, so the worker can read
+  // sourceLanes[0..numSources) without locking.
+  struct SourceLane {
+    SourceLane(float weight_, double maxRatePerSecond_, size_t queueCapacity);
+    SomRingBuffer<SomInstanceDataT> queue;
+    std::atomic<float> weight;
+    const double maxRatePerSecond;
+    const double burstSize;
+    // Producer-only token bucket
+    double tokens;
+    uint64_t lastRefillMicros { 0 };
+    std::atomic<uint64_t> accepted { 0 };
+    std::atomic<uint64_t> rateLimited { 0 };
+    std::atomic<uint64_t> dropped { 0 };
+    // Worker-only
+    alignas(64) std::atomic<uint64_t> consumed { 0 };
+    uint64_t discardThroughCount { 0 };
+    double pass { 0.0 }; // stride-scheduling position; lowest backlogged pass is served next
+  };
+  std::array<std::unique_ptr<SourceLane>, maxSources> sourceLanes;
+  std::atomic<int> numSources { 0 };
+  std::mutex sourceRegistrationMutex;
+  // Once sources are registered the worker can't block on newInstanceData alone, so it sleeps here
+  // and every push (source or shared channel) wakes it.
+  std::mutex wakeMutex;
+  std::condition_variable wakeCondition;
+  std::atomic<bool> isWorkerWaiting { false };
+  double channelPass { 0.0 }; // worker-only: the shared channel is scheduled like a weight-1 source
+  double globalPass { 0.0 }; // worker-only: pass of the last instance served
+  uint64_t visibleInstanceCount { 0 };
+
+  // Lets update() skip the channel entirely when nothing new has been published.
+  std::atomic<uint64_t> publishedFrameCount { 0 };
+  uint64_t receivedFrameCount { 0 };
   
   void updatePalette();
+  void postCommand(WorkerCommand&& command);
+  void flushOverflowCommands();
+  void processCommands();
+  void applyCommand(WorkerCommand& command);
+  void resetSom();
+  void publishIterationCounts();
+  bool takeInstance(); // counts a consumed instance; false if it predates the last reset
+  bool receiveInstance(SomInstanceDataT& instanceData, int64_t timeoutMillis);
+  bool mergeSources(SomInstanceDataT& instanceData);
+  void wakeWorker();
+  bool hasQueuedInstances() const;
+  void setupSomAtSize(int w, int h, float initialLearningRate, int numIterations);
+  void setupCoarseToFineLevels();
+  void splitLevelIterations(size_t firstLevel, int budget);
+  void advanceCoarseToFineLevel();
+  void applyPendingWorkerSettings();
+  bool trainInstance(const SomInstanceDataT& instanceData); // true if the result should be published
+  void publishPixels();
   
   bool visible = false;
 };
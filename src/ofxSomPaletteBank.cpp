@@ -0,0 +1,365 @@
+#include "ofxSomPaletteBank.h"
+#include "ofxSomPaletteTrace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+SomPaletteBank::SomPaletteBank(int numMaps_, int width_, int height_, float initialLearningRate_, int numIterations_) :
+numMaps { std::max(1, numMaps_) },
+width { width_ },
+height { height_ },
+cellsPerMap { static_cast<size_t>(width_) * static_cast<size_t>(height_) },
+initialLearningRate { initialLearningRate_ },
+numIterations { numIterations_ },
+iterations(numMaps),
+requestedResetGenerations(numMaps),
+warmStartRequestedMix(numMaps)
+{
+  setThreadName("SomPaletteBank " + ofToString(this));
+
+  // Same schedule shape as ofxSelfOrganizingMap: radius and learning rate decay exponentially
+  // and the radius reaches 1 cell at the final iteration.
+  mapRadius = std::max(1.0f, std::max(width, height) * 0.5f);
+  timeConstant = static_cast<float>(numIterations) / std::log(std::max(mapRadius, 1.0001f));
+
+  weights.resize(static_cast<size_t>(numMaps) * 3 * cellsPerMap);
+  cellX.resize(cellsPerMap);
+  cellY.resize(cellsPerMap);
+  scratch.resize(cellsPerMap);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      cellX[y * width + x] = static_cast<float>(x);
+      cellY[y * width + x] = static_cast<float>(y);
+    }
+  }
+
+  shouldWarmStart.assign(numMaps, 1);
+  warmStartMixes.assign(numMaps, 0.60f);
+  hasTrainedSinceReset.assign(numMaps, 0);
+  appliedResetGenerations.assign(numMaps, 0);
+  isMapDirty.assign(numMaps, 0);
+  resetGenerations.assign(numMaps, 0);
+  ingestRings.reserve(numMaps);
+  for (int m = 0; m < numMaps; ++m) {
+    ingestRings.push_back(std::make_unique<SomRingBuffer<SomInstanceDataT>>(ingestCapacity));
+    iterations[m].store(0);
+    requestedResetGenerations[m].store(0);
+    warmStartRequestedMix[m].store(-1.0f);
+    initializeMap(m);
+  }
+
+  // Avoid bright startup flashes before any audio arrives.
+  atlasPixels.allocate(width, height * numMaps, OF_IMAGE_COLOR);
+  std::fill(atlasPixels.getData(), atlasPixels.getData() + cellsPerMap * numMaps * 3, 0.0f);
+  palettes.assign(static_cast<size_t>(numMaps) * SomPalette::size, ofColor::black);
+
+  startThread();
+}
+
+SomPaletteBank::~SomPaletteBank() {
+  stopThread();
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wakeCondition.notify_one();
+  }
+  newFrames.close();
+  recycledFrames.close();
+  waitForThread(true);
+}
+
+void SomPaletteBank::addInstanceData(int mapIndex, SomInstanceDataT instanceData) {
+  if (mapIndex < 0 || mapIndex >= numMaps) return;
+  if (isIterating(mapIndex) && ingestRings[mapIndex]->push(instanceData)) wakeWorker();
+}
+
+void SomPaletteBank::reset(int mapIndex) {
+  if (mapIndex < 0 || mapIndex >= numMaps) return;
+  requestedResetGenerations[mapIndex].store(++resetGenerations[mapIndex]);
+  wakeWorker();
+
+  // Like SomPalette::reset: blank now, and update() keeps blanking frames trained before the reset.
+  blankMap(atlasPixels.getData(), palettes, mapIndex);
+  if (atlasTexture.isAllocated()) atlasTexture.loadData(atlasPixels);
+}
+
+void SomPaletteBank::blankMap(float* atlasData, std::vector<ofColor>& palettesOut, int mapIndex) const {
+  float* mapData = atlasData + static_cast<size_t>(mapIndex) * cellsPerMap * 3;
+  std::fill(mapData, mapData + cellsPerMap * 3, 0.0f);
+  std::fill(palettesOut.begin() + static_cast<size_t>(mapIndex) * SomPalette::size,
+            palettesOut.begin() + static_cast<size_t>(mapIndex + 1) * SomPalette::size, ofColor::black);
+}
+
+void SomPaletteBank::wakeWorker() {
+  // Pairs with the fence in waitForWork: either the worker sees what was just queued before it
+  // sleeps, or we see that it is waiting and notify it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!isWorkerWaiting.load(std::memory_order_relaxed)) return;
+  std::lock_guard<std::mutex> lock(wakeMutex);
+  wakeCondition.notify_one();
+}
+
+void SomPaletteBank::warmStartFromFirstInstance(int mapIndex, float mix) {
+  if (mapIndex < 0 || mapIndex >= numMaps) return;
+  warmStartRequestedMix[mapIndex].store(mix);
+}
+
+void SomPaletteBank::setColorizerGains(float grayGain, float chromaGain) {
+  colorizerGrayGain.store(grayGain);
+  colorizerChromaGain.store(chromaGain);
+}
+
+void SomPaletteBank::initializeMap(int mapIndex) {
+  // Deterministic per-map seed so banks are reproducible run to run.
+  std::mt19937 rng(0x5eed0000u + static_cast<uint32_t>(mapIndex));
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+  float* w = weights.data() + static_cast<size_t>(mapIndex) * 3 * cellsPerMap;
+  for (size_t i = 0; i < 3 * cellsPerMap; ++i) {
+    w[i] = uniform(rng);
+  }
+  shouldWarmStart[mapIndex] = 1;
+}
+
+void SomPaletteBank::warmStartMap(int mapIndex, const SomInstanceDataT& instanceData, float mix) {
+  // Same idea as SomPalette: pull the map toward the first instance with a small coordinate-hashed jitter.
+  const float invMix = 1.0f - mix;
+  const float noiseAmp = 0.08f * invMix;
+  float* w = weights.data() + static_cast<size_t>(mapIndex) * 3 * cellsPerMap;
+
+  for (size_t cell = 0; cell < cellsPerMap; ++cell) {
+    uint32_t h = static_cast<uint32_t>(cellX[cell]) * 73856093u ^ static_cast<uint32_t>(cellY[cell]) * 19349663u;
+    for (int z = 0; z < 3; ++z) {
+      h ^= static_cast<uint32_t>((z + 1) * 83492791);
+      h *= 1664525u;
+      h += 1013904223u;
+
+      const float n01 = static_cast<float>(h) / static_cast<float>(std::numeric_limits<uint32_t>::max());
+      const float n = (n01 * 2.0f - 1.0f) * noiseAmp;
+
+      const float target = ofClamp(static_cast<float>(instanceData[z]) + n, 0.0f, 1.0f);
+      float& c = w[z * cellsPerMap + cell];
+      c = ofClamp(invMix * c + mix * target, 0.0f, 1.0f);
+    }
+  }
+}
+
+void SomPaletteBank::trainMap(int mapIndex, const SomInstanceDataT& instanceData, int iteration) {
+  float* w0 = weights.data() + static_cast<size_t>(mapIndex) * 3 * cellsPerMap;
+  float* w1 = w0 + cellsPerMap;
+  float* w2 = w1 + cellsPerMap;
+  float* s = scratch.data();
+  const size_t n = cellsPerMap;
+
+  const float x0 = static_cast<float>(instanceData[0]);
+  const float x1 = static_cast<float>(instanceData[1]);
+  const float x2 = static_cast<float>(instanceData[2]);
+
+  // Best matching unit: distances in one vectorizable pass, then a scalar argmin.
+  for (size_t i = 0; i < n; ++i) {
+    const float d0 = w0[i] - x0;
+    const float d1 = w1[i] - x1;
+    const float d2 = w2[i] - x2;
+    s[i] = d0 * d0 + d1 * d1 + d2 * d2;
+  }
+  const size_t bmu = static_cast<size_t>(std::min_element(s, s + n) - s);
+  const float bx = cellX[bmu];
+  const float by = cellY[bmu];
+
+  const float decay = std::exp(-static_cast<float>(iteration) / timeConstant);
+  const float learningRate = initialLearningRate * decay;
+  const float radius = mapRadius * decay;
+  const float radius2 = radius * radius;
+  const float invTwoRadius2 = 1.0f / (2.0f * radius2);
+
+  // Neighbourhood influence (already scaled by the learning rate), branch-free so it vectorizes.
+  for (size_t i = 0; i < n; ++i) {
+    const float dx = cellX[i] - bx;
+    const float dy = cellY[i] - by;
+    const float g2 = dx * dx + dy * dy;
+    const float influence = learningRate * std::exp(-g2 * invTwoRadius2);
+    s[i] = (g2 < radius2) ? influence : 0.0f;
+  }
+  // Always move the BMU itself, even once the radius has shrunk below one cell.
+  s[bmu] = learningRate;
+
+  for (size_t i = 0; i < n; ++i) w0[i] += s[i] * (x0 - w0[i]);
+  for (size_t i = 0; i < n; ++i) w1[i] += s[i] * (x1 - w1[i]);
+  for (size_t i = 0; i < n; ++i) w2[i] += s[i] * (x2 - w2[i]);
+}
+
+void SomPaletteBank::colorizeInto(Frame& frame) {
+  SOM_PALETTE_TRACE_ZONE("SomPaletteBank::colorize");
+  const float grayGain = colorizerGrayGain.load();
+  const float chromaGain = colorizerChromaGain.load();
+  if (grayGain != appliedGrayGain || chromaGain != appliedChromaGain) {
+    // New gains recolour every map, not just the ones trained this sweep.
+    colorizer.setGains(grayGain, chromaGain);
+    appliedGrayGain = grayGain;
+    appliedChromaGain = chromaGain;
+    std::fill(isMapDirty.begin(), isMapDirty.end(), 1);
+  }
+
+  frame.maps.clear();
+  for (int m = 0; m < numMaps; ++m) {
+    if (isMapDirty[m]) frame.maps.push_back(m);
+  }
+  frame.pixels.resize(frame.maps.size() * cellsPerMap * 3);
+  frame.palettes.resize(frame.maps.size() * SomPalette::size);
+  frame.resetGenerations.resize(frame.maps.size());
+
+  std::array<ofColor, SomPalette::size> mapPalette;
+  for (size_t k = 0; k < frame.maps.size(); ++k) {
+    const int m = frame.maps[k];
+    isMapDirty[m] = 0;
+    frame.resetGenerations[k] = appliedResetGenerations[m];
+    float* mapDst = frame.pixels.data() + k * cellsPerMap * 3;
+    auto paletteDst = frame.palettes.begin() + k * SomPalette::size;
+
+    if (!hasTrainedSinceReset[m]) {
+      std::fill(mapDst, mapDst + cellsPerMap * 3, 0.0f);
+      std::fill(paletteDst, paletteDst + SomPalette::size, ofColor::black);
+      continue;
+    }
+    const float* w0 = weights.data() + static_cast<size_t>(m) * 3 * cellsPerMap;
+    const float* w1 = w0 + cellsPerMap;
+    const float* w2 = w1 + cellsPerMap;
+
+    colorizer.colorize(w0, w1, w2, mapDst, cellsPerMap);
+
+    SomPalette::extractPalette(mapDst, cellsPerMap, mapPalette);
+    std::copy(mapPalette.begin(), mapPalette.end(), paletteDst);
+  }
+}
+
+bool SomPaletteBank::trainPendingInstances() {
+  SOM_PALETTE_TRACE_ZONE("SomPaletteBank::train");
+  SomInstanceDataT instanceData;
+  bool trained = false;
+
+  for (int m = 0; m < numMaps; ++m) {
+    const uint64_t requestedResetGeneration = requestedResetGenerations[m].load();
+    if (requestedResetGeneration != appliedResetGenerations[m]) {
+      appliedResetGenerations[m] = requestedResetGeneration;
+      initializeMap(m);
+      ingestRings[m]->clear();
+      iterations[m].store(0);
+      hasTrainedSinceReset[m] = 0;
+      isMapDirty[m] = 1;
+    }
+    const float requestedMix = warmStartRequestedMix[m].exchange(-1.0f);
+    if (requestedMix >= 0.0f) {
+      warmStartMixes[m] = requestedMix;
+      shouldWarmStart[m] = 1;
+    }
+
+    int iteration = iterations[m].load();
+    for (size_t k = 0; k < maxInstancesPerMapPerSweep && iteration < numIterations; ++k) {
+      if (!ingestRings[m]->pop(instanceData)) break;
+      if (shouldWarmStart[m]) {
+        warmStartMap(m, instanceData, warmStartMixes[m]);
+        shouldWarmStart[m] = 0;
+      }
+      trainMap(m, instanceData, iteration++);
+      hasTrainedSinceReset[m] = 1;
+      isMapDirty[m] = 1;
+      trained = true;
+    }
+    iterations[m].store(iteration);
+  }
+  return trained;
+}
+
+void SomPaletteBank::threadedFunction() {
+  SOM_PALETTE_TRACE_THREAD_NAME(getThreadName());
+
+  while (isThreadRunning()) {
+    const bool trained = trainPendingInstances();
+
+    if (!trained) {
+      waitForWork();
+      continue;
+    }
+
+    Frame frame;
+    recycledFrames.tryReceive(frame); // otherwise start a new one
+    colorizeInto(frame);
+    newFrames.send(std::move(frame));
+  }
+}
+
+bool SomPaletteBank::hasPendingWork() const {
+  for (int m = 0; m < numMaps; ++m) {
+    if (requestedResetGenerations[m].load() != appliedResetGenerations[m]) return true;
+    // Instances left over once a map has finished wait for its next reset.
+    if (iterations[m].load() < numIterations && ingestRings[m]->sizeApprox() > 0) return true;
+  }
+  return false;
+}
+
+void SomPaletteBank::waitForWork() {
+  std::unique_lock<std::mutex> lock(wakeMutex);
+  isWorkerWaiting.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  wakeCondition.wait(lock, [this] { return !isThreadRunning() || hasPendingWork(); });
+  isWorkerWaiting.store(false, std::memory_order_relaxed);
+}
+
+void SomPaletteBank::update() {
+  Frame frame;
+  bool isNewFrameReady = false;
+  // Each frame only holds the maps that changed, so apply every one in order.
+  while (newFrames.tryReceive(frame)) {
+    SOM_PALETTE_TRACE_ZONE("SomPaletteBank::update");
+    for (size_t k = 0; k < frame.maps.size(); ++k) {
+      const int m = frame.maps[k];
+      if (frame.resetGenerations[k] != resetGenerations[m]) continue; // trained before reset(), stays blank
+      const float* src = frame.pixels.data() + k * cellsPerMap * 3;
+      std::copy(src, src + cellsPerMap * 3, atlasPixels.getData() + static_cast<size_t>(m) * cellsPerMap * 3);
+      std::copy(frame.palettes.begin() + k * SomPalette::size, frame.palettes.begin() + (k + 1) * SomPalette::size,
+                palettes.begin() + static_cast<size_t>(m) * SomPalette::size);
+    }
+    recycledFrames.send(std::move(frame));
+    isNewFrameReady = true;
+  }
+  if (!isNewFrameReady) return;
+
+  if (!atlasTexture.isAllocated()) {
+    // Nearest filtering so neighbouring maps don't bleed into each other at the seams.
+    atlasTexture.allocate(atlasPixels, false);
+    atlasTexture.setTextureMinMagFilter(GL_NEAREST, GL_NEAREST);
+  }
+  atlasTexture.loadData(atlasPixels);
+}
+
+const float* SomPaletteBank::getMapPixelData(int mapIndex) const {
+  return atlasPixels.getData() + static_cast<size_t>(mapIndex) * cellsPerMap * 3;
+}
+
+ofRectangle SomPaletteBank::getMapTextureRect(int mapIndex) const {
+  return ofRectangle(0, mapIndex * height, width, height);
+}
+
+ofColor SomPaletteBank::getColorAt(int mapIndex, int x, int y) const {
+  const float* c = getMapPixelData(mapIndex) + (static_cast<size_t>(y) * width + x) * 3;
+  return ofFloatColor(c[0], c[1], c[2]);
+}
+
+void SomPaletteBank::draw(int mapIndex, bool paletteOnly) const {
+  ofPushStyle();
+  ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+  ofSetColor(255);
+
+  if (!paletteOnly && atlasTexture.isAllocated()) {
+    const ofRectangle r = getMapTextureRect(mapIndex);
+    atlasTexture.drawSubsection(0, 0, 1.0, 1.0, r.x, r.y, r.width, r.height);
+  }
+
+  float chipWidth = 1.0 / SomPalette::size;
+  ofFill();
+  for (size_t i = 0; i < SomPalette::size; i++) {
+    ofSetColor(getColor(mapIndex, i));
+    ofDrawRectangle(i*chipWidth, 0.0, chipWidth, chipWidth / 2.0);
+  }
+  ofPopStyle();
+}
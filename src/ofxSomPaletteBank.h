@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ofMain.h"
+#include "ofxSomColorizer.h"
+#include "ofxSomPalette.h"
+#include "ofxSomRingBuffer.h"
+
+// Many small palettes (e.g. one per instrument or stem) trained by a single worker.
+//
+// Rather than N SomPalette objects each with their own SOM, thread, channels, pixels and texture,
+// the bank keeps every map's weights in one contiguous structure-of-arrays arena:
+//   weights[(map * 3 + feature) * cellsPerMap + cell]
+// so each training step is a handful of straight, auto-vectorizable float loops over one map.
+//
+// Each map has its own lock-free ingest ring (one producer per map). Each time it wakes, the worker
+// drains every ring and trains all maps in one sweep, then colorizes and picks palettes for just the
+// maps that changed, and update() patches those into the atlas. With nothing left to train the
+// worker sleeps until a producer pushes or a map is reset.
+// The atlas stacks the maps vertically (width x height*numMaps) so each map's pixels are contiguous
+// and a per-map view is just an offset into the atlas. One texture holds the whole atlas.
+class SomPaletteBank: public ofThread {
+
+public:
+  SomPaletteBank(int numMaps_ = 16, int width_ = 8, int height_ = 8, float initialLearningRate_ = 0.01, int numIterations_ = 5000);
+  ~SomPaletteBank();
+
+  // Safe to call from one producer thread per map. Drops the instance if the map's ring is full.
+  void addInstanceData(int mapIndex, SomInstanceDataT instanceData);
+  // Main thread. Blanks the map's pixels and palette until it trains again.
+  void reset(int mapIndex);
+  void warmStartFromFirstInstance(int mapIndex, float mix = 0.85f);
+  bool isIterating(int mapIndex) const { return getCurrentIteration(mapIndex) < numIterations; }
+  int getCurrentIteration(int mapIndex) const { return iterations[mapIndex].load(); }
+  int getNumIterations() const { return numIterations; }
+  void setColorizerGains(float grayGain, float chromaGain);
+
+  void update(); // move the atlas into a GL texture on main thread
+
+  // Draws one map (and its palette chips) into the unit square, like SomPalette::draw.
+  void draw(int mapIndex, bool paletteOnly = false) const;
+
+  int getNumMaps() const { return numMaps; }
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+
+  const ofFloatPixels& getAtlasPixelsRef() const { return atlasPixels; }
+  const ofTexture& getAtlasTexture() const { return atlasTexture; }
+  // Packed RGB floats, width * height cells, for one map. Points into the atlas.
+  const float* getMapPixelData(int mapIndex) const;
+  // Texture-space rectangle of one map within the atlas texture.
+  ofRectangle getMapTextureRect(int mapIndex) const;
+  ofColor getColorAt(int mapIndex, int x, int y) const;
+  ofColor getColor(int mapIndex, int i) const { return palettes[mapIndex * SomPalette::size + i]; }
+
+  static constexpr size_t ingestCapacity = 256;
+  static constexpr size_t maxInstancesPerMapPerSweep = 64;
+
+protected:
+  void threadedFunction() override;
+
+private:
+  // Just the maps that changed in one sweep. Frames go back to the worker once applied, so their
+  // buffers are reused rather than reallocated every sweep.
+  struct Frame {
+    std::vector<int> maps;
+    std::vector<float> pixels; // packed RGB, cellsPerMap per entry of maps
+    std::vector<ofColor> palettes; // SomPalette::size per entry of maps
+    std::vector<uint64_t> resetGenerations; // per entry of maps, as applied by the worker
+  };
+
+  int numMaps, width, height;
+  size_t cellsPerMap;
+  float initialLearningRate;
+  int numIterations;
+  float mapRadius;
+  float timeConstant;
+
+  // Worker-owned SOM state
+  std::vector<float> weights; // SoA arena, see class comment
+  std::vector<float> cellX, cellY; // grid coordinates shared by every map
+  std::vector<float> scratch; // per-cell distances, then neighbourhood influence
+  std::vector<uint8_t> shouldWarmStart;
+  std::vector<float> warmStartMixes;
+  std::vector<uint8_t> hasTrainedSinceReset; // untrained maps stay blank rather than showing random weights
+  std::vector<uint64_t> appliedResetGenerations;
+  std::vector<uint8_t> isMapDirty; // trained or reset since its pixels were last sent
+  SomColorizer colorizer;
+  float appliedGrayGain { 1.0f };
+  float appliedChromaGain { 1.25f };
+
+  std::vector<std::unique_ptr<SomRingBuffer<SomInstanceDataT>>> ingestRings;
+  std::vector<std::atomic<int>> iterations;
+  std::vector<std::atomic<uint64_t>> requestedResetGenerations; // reset pending while != applied
+  std::vector<std::atomic<float>> warmStartRequestedMix; // < 0 means no request
+
+  std::atomic<float> colorizerGrayGain { 1.0f };
+  std::atomic<float> colorizerChromaGain { 1.25f };
+
+  ofThreadChannel<Frame> newFrames;
+  ofThreadChannel<Frame> recycledFrames;
+
+  // Producers only take the mutex to notify when the worker is (about to be) waiting.
+  std::mutex wakeMutex;
+  std::condition_variable wakeCondition;
+  std::atomic<bool> isWorkerWaiting { false };
+
+  // Main-thread outputs
+  ofFloatPixels atlasPixels;
+  ofTexture atlasTexture;
+  std::vector<ofColor> palettes;
+  std::vector<uint64_t> resetGenerations; // per map, main thread
+
+  void wakeWorker();
+  bool hasPendingWork() const;
+  void waitForWork();
+  void blankMap(float* atlasData, std::vector<ofColor>& palettesOut, int mapIndex) const;
+  void initializeMap(int mapIndex);
+  void warmStartMap(int mapIndex, const SomInstanceDataT& instanceData, float mix);
+  void trainMap(int mapIndex, const SomInstanceDataT& instanceData, int iteration);
+  bool trainPendingInstances(); // one sweep over every map's ring; true if anything was trained
+  void colorizeInto(Frame& frame); // the dirty maps only
+};
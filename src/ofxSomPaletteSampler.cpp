@@ -0,0 +1,88 @@
+#include "ofxSomPaletteSampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+constexpr size_t blockSize = 64;
+
+// GL_MIRRORED_REPEAT applied to an integer texel index.
+inline int32_t mirrorIndex(int32_t i, int32_t size) {
+  const int32_t period = 2 * size;
+  int32_t m = i % period;
+  m += (m < 0) ? period : 0;
+  return (m < size) ? m : (period - 1 - m);
+}
+
+} // namespace
+
+void sampleBilinearMirrored(const ofFloatPixels& pixels, const glm::vec2* uvs, ofFloatColor* colorsOut, size_t count) {
+  const int32_t w = static_cast<int32_t>(pixels.getWidth());
+  const int32_t h = static_cast<int32_t>(pixels.getHeight());
+  if (w <= 0 || h <= 0 || pixels.getNumChannels() < 3) {
+    std::fill(colorsOut, colorsOut + count, ofFloatColor(0.0f, 0.0f, 0.0f));
+    return;
+  }
+
+  const float* data = pixels.getData();
+  const size_t channels = pixels.getNumChannels();
+  const size_t rowStride = static_cast<size_t>(w) * channels;
+  const float fw = static_cast<float>(w);
+  const float fh = static_cast<float>(h);
+
+  int32_t x0[blockSize], x1[blockSize], y0[blockSize], y1[blockSize];
+  float tx[blockSize], ty[blockSize];
+
+  for (size_t base = 0; base < count; base += blockSize) {
+    const size_t n = std::min(blockSize, count - base);
+    const glm::vec2* uv = uvs + base;
+
+    // Texel-space coordinates and weights. Reduced by the mirror period while still in float, so the
+    // int cast stays in range however far out the UV is; NaN and infinities sample texel 0.
+    for (size_t k = 0; k < n; ++k) {
+      float fx = uv[k].x * fw - 0.5f;
+      float fy = uv[k].y * fh - 0.5f;
+      fx = std::isfinite(fx) ? std::fmod(fx, 2.0f * fw) : 0.0f;
+      fy = std::isfinite(fy) ? std::fmod(fy, 2.0f * fh) : 0.0f;
+      const float flx = std::floor(fx);
+      const float fly = std::floor(fy);
+      tx[k] = fx - flx;
+      ty[k] = fy - fly;
+      x0[k] = static_cast<int32_t>(flx);
+      y0[k] = static_cast<int32_t>(fly);
+    }
+    for (size_t k = 0; k < n; ++k) {
+      x1[k] = mirrorIndex(x0[k] + 1, w);
+      y1[k] = mirrorIndex(y0[k] + 1, h);
+      x0[k] = mirrorIndex(x0[k], w);
+      y0[k] = mirrorIndex(y0[k], h);
+    }
+
+    // Gather + blend
+    for (size_t k = 0; k < n; ++k) {
+      const float* row0 = data + static_cast<size_t>(y0[k]) * rowStride;
+      const float* row1 = data + static_cast<size_t>(y1[k]) * rowStride;
+      const float* c00 = row0 + static_cast<size_t>(x0[k]) * channels;
+      const float* c10 = row0 + static_cast<size_t>(x1[k]) * channels;
+      const float* c01 = row1 + static_cast<size_t>(x0[k]) * channels;
+      const float* c11 = row1 + static_cast<size_t>(x1[k]) * channels;
+
+      const float wx1 = tx[k];
+      const float wy1 = ty[k];
+      const float wx0 = 1.0f - wx1;
+      const float wy0 = 1.0f - wy1;
+      const float w00 = wx0 * wy0;
+      const float w10 = wx1 * wy0;
+      const float w01 = wx0 * wy1;
+      const float w11 = wx1 * wy1;
+
+      ofFloatColor& out = colorsOut[base + k];
+      out.r = w00 * c00[0] + w10 * c10[0] + w01 * c01[0] + w11 * c11[0];
+      out.g = w00 * c00[1] + w10 * c10[1] + w01 * c01[1] + w11 * c11[1];
+      out.b = w00 * c00[2] + w10 * c10[2] + w01 * c01[2] + w11 * c11[2];
+      out.a = 1.0f;
+    }
+  }
+}
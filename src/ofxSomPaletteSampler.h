@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+#include "ofMain.h"
+
+// CPU equivalent of sampling a palette texture set up with GL_LINEAR + GL_MIRRORED_REPEAT.
+//
+// UVs are normalized (0..1 spans the field once; outside that the field mirrors). Texel centres sit
+// at (i + 0.5) / size, and mirroring is applied to the integer texel indices exactly as GL does,
+// so CPU consumers (e.g. particle systems) see the same colours the GPU would.
+//
+// Work is done in fixed-size blocks: indices and weights for a block are computed in flat
+// arrays first (vectorizable), then the texels are gathered and blended.
+void sampleBilinearMirrored(const ofFloatPixels& pixels, const glm::vec2* uvs, ofFloatColor* colorsOut, size_t count);
@@ -0,0 +1,116 @@
+#include "ofxSomPaletteSharedMemory.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SomPaletteSharedMemoryPublisher::SomPaletteSharedMemoryPublisher(const std::string& name_, bool unlinkOnDestroy_) :
+name { name_ },
+unlinkOnDestroy { unlinkOnDestroy_ }
+{}
+
+SomPaletteSharedMemoryPublisher::~SomPaletteSharedMemoryPublisher() {
+  close();
+}
+
+bool SomPaletteSharedMemoryPublisher::open(uint32_t width, uint32_t height) {
+#ifdef _WIN32
+  ofLogError("SomPaletteSharedMemoryPublisher") << "POSIX shared memory is not available on this platform";
+  return false;
+#else
+  // Readers only map it read-only; nobody else gets to write into the segment.
+  fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    ofLogError("SomPaletteSharedMemoryPublisher") << "shm_open " << name << ": " << std::strerror(errno);
+    return false;
+  }
+
+  mappingSize = SomPaletteSharedMemory::segmentSize(width, height);
+  if (ftruncate(fd, static_cast<off_t>(mappingSize)) != 0) {
+    ofLogError("SomPaletteSharedMemoryPublisher") << "ftruncate " << name << ": " << std::strerror(errno);
+    close();
+    return false;
+  }
+
+  mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    ofLogError("SomPaletteSharedMemoryPublisher") << "mmap " << name << ": " << std::strerror(errno);
+    close();
+    return false;
+  }
+
+  // Fresh segment: write the immutable fields, then mark it valid by writing the magic last.
+  std::memset(mapping, 0, SomPaletteSharedMemory::pixelsOffset);
+  header = new (mapping) SomPaletteSharedMemory::Header();
+  header->version = SomPaletteSharedMemory::version;
+  header->width = width;
+  header->height = height;
+  header->paletteSize = SomPaletteSharedMemory::paletteSize;
+  header->sequence.store(0);
+  header->generation.store(0);
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = SomPaletteSharedMemory::magic;
+  return true;
+#endif
+}
+
+void SomPaletteSharedMemoryPublisher::close() {
+#ifndef _WIN32
+  if (mapping) munmap(mapping, mappingSize);
+  if (fd >= 0) {
+    ::close(fd);
+    if (unlinkOnDestroy) shm_unlink(name.c_str());
+  }
+#endif
+  mapping = nullptr;
+  header = nullptr;
+  fd = -1;
+}
+
+void SomPaletteSharedMemoryPublisher::publish(const ofFloatPixels& pixels, const SomPaletteColorsT& palette) {
+  const uint32_t width = static_cast<uint32_t>(pixels.getWidth());
+  const uint32_t height = static_cast<uint32_t>(pixels.getHeight());
+  if (width == 0 || height == 0 || pixels.getNumChannels() != 3) return;
+
+  if (!header) {
+    if (hasFailed) return;
+    if (!open(width, height)) {
+      hasFailed = true;
+      return;
+    }
+  }
+  if (header->width != width || header->height != height) {
+    ofLogWarning("SomPaletteSharedMemoryPublisher") << "snapshot size changed to " << width << "x" << height << "; skipping";
+    return;
+  }
+
+  // Seqlock write: odd sequence while the snapshot is inconsistent.
+  const uint32_t seq = header->sequence.load(std::memory_order_relaxed);
+  header->sequence.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  float* dst = reinterpret_cast<float*>(static_cast<uint8_t*>(mapping) + SomPaletteSharedMemory::pixelsOffset);
+  std::memcpy(dst, pixels.getData(), static_cast<size_t>(width) * height * 3 * sizeof(float));
+  for (size_t i = 0; i < SomPaletteSharedMemory::paletteSize; ++i) {
+    header->palette[i * 3] = palette[i].r;
+    header->palette[i * 3 + 1] = palette[i].g;
+    header->palette[i * 3 + 2] = palette[i].b;
+  }
+  header->publishMicros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+  header->generation.fetch_add(1, std::memory_order_relaxed);
+
+  header->sequence.store(seq + 2, std::memory_order_release);
+}
+
+uint64_t SomPaletteSharedMemoryPublisher::getGeneration() const {
+  return header ? header->generation.load() : 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+
+#include "ofMain.h"
+#include "ofxSomPaletteSink.h"
+#include "ofxSomPaletteSharedMemoryLayout.h"
+
+// Publishes each palette snapshot (pixel field + 8-colour palette) into a POSIX shared-memory
+// segment so other local processes can read it with SomPaletteSharedMemoryReader.
+//
+//   auto publisher = std::make_shared<SomPaletteSharedMemoryPublisher>("/som-palette");
+//   somPalette.addSink(publisher);
+//
+// The segment is created on the first publish, sized for that snapshot; later snapshots must have
+// the same dimensions. Not available on Windows (publish() is a no-op there).
+class SomPaletteSharedMemoryPublisher: public SomPaletteSink {
+public:
+  // name must start with '/' and contain no other slashes (shm_open rules).
+  explicit SomPaletteSharedMemoryPublisher(const std::string& name_, bool unlinkOnDestroy_ = true);
+  ~SomPaletteSharedMemoryPublisher();
+
+  void publish(const ofFloatPixels& pixels, const SomPaletteColorsT& palette) override;
+
+  bool isOpen() const { return header != nullptr; }
+  uint64_t getGeneration() const;
+
+private:
+  std::string name;
+  bool unlinkOnDestroy;
+  int fd { -1 };
+  void* mapping { nullptr };
+  size_t mappingSize { 0 };
+  SomPaletteSharedMemory::Header* header { nullptr };
+  bool hasFailed { false };
+
+  bool open(uint32_t width, uint32_t height);
+  void close();
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Layout of a palette snapshot in a POSIX shared-memory segment.
+//
+// Shared by the publisher (SomPaletteSharedMemoryPublisher) and the standalone reader
+// (SomPaletteSharedMemoryReader), which deliberately doesn't depend on openFrameworks.
+//
+// Writes are guarded by a seqlock: `sequence` is odd while a write is in progress, and a reader
+// that sees the same even value before and after reading knows it read a consistent snapshot.
+// `generation` counts published snapshots so readers can cheaply tell if anything changed.
+namespace SomPaletteSharedMemory {
+
+constexpr uint32_t magic = 0x534f4d50; // "SOMP"
+constexpr uint32_t version = 1;
+constexpr uint32_t paletteSize = 8;
+
+struct alignas(64) Header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t paletteSize;
+  uint32_t reserved;
+  std::atomic<uint32_t> sequence;
+  std::atomic<uint64_t> generation;
+  uint64_t publishMicros; // std::chrono::steady_clock time of the snapshot in microseconds, comparable across local processes
+  uint8_t palette[SomPaletteSharedMemory::paletteSize * 3]; // RGB, sorted by lightness
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "seqlock needs lock-free 32-bit atomics across processes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "generation needs lock-free 64-bit atomics across processes");
+
+// Pixels follow the header: width * height * 3 floats, row-major RGB.
+constexpr size_t pixelsOffset = sizeof(Header);
+
+inline size_t segmentSize(uint32_t width, uint32_t height) {
+  return pixelsOffset + static_cast<size_t>(width) * static_cast<size_t>(height) * 3 * sizeof(float);
+}
+
+} // namespace SomPaletteSharedMemory
@@ -0,0 +1,59 @@
+#include "ofxSomPaletteSharedMemoryReader.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SomPaletteSharedMemoryReader::~SomPaletteSharedMemoryReader() {
+  close();
+}
+
+bool SomPaletteSharedMemoryReader::open(const std::string& name) {
+  close();
+#ifdef _WIN32
+  (void)name;
+  return false;
+#else
+  fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < SomPaletteSharedMemory::pixelsOffset) {
+    close();
+    return false;
+  }
+  mappingSize = static_cast<size_t>(st.st_size);
+
+  mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    close();
+    return false;
+  }
+
+  header = static_cast<const SomPaletteSharedMemory::Header*>(mapping);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header->magic != SomPaletteSharedMemory::magic
+      || header->version != SomPaletteSharedMemory::version
+      || mappingSize < SomPaletteSharedMemory::segmentSize(header->width, header->height)) {
+    close();
+    return false;
+  }
+  pixels = reinterpret_cast<const float*>(static_cast<const uint8_t*>(mapping) + SomPaletteSharedMemory::pixelsOffset);
+  return true;
+#endif
+}
+
+void SomPaletteSharedMemoryReader::close() {
+#ifndef _WIN32
+  if (mapping) munmap(mapping, mappingSize);
+  if (fd >= 0) ::close(fd);
+#endif
+  mapping = nullptr;
+  header = nullptr;
+  pixels = nullptr;
+  fd = -1;
+}
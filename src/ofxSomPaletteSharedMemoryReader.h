@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "ofxSomPaletteSharedMemoryLayout.h"
+
+// Reads palette snapshots published by SomPaletteSharedMemoryPublisher from another process.
+//
+// Standalone: depends only on the C++ standard library and POSIX, so it can be dropped into a
+// non-openFrameworks app (projection mapping, lighting control, ...). After open(), reading costs
+// no syscalls and no copies: read() hands the callback pointers straight into the mapping.
+//
+//   SomPaletteSharedMemoryReader reader;
+//   if (reader.open("/som-palette")) {
+//     reader.read([&](const SomPaletteSharedMemoryReader::View& v) { useColor(v.palette[0], ...); });
+//   }
+class SomPaletteSharedMemoryReader {
+public:
+  struct View {
+    uint32_t width;
+    uint32_t height;
+    const float* pixels; // width * height * 3 floats, row-major RGB in [0..1]
+    const uint8_t* palette; // paletteSize * 3 bytes, RGB
+    uint64_t generation;
+    uint64_t publishMicros; // steady_clock microseconds, see Header
+  };
+
+  SomPaletteSharedMemoryReader() = default;
+  ~SomPaletteSharedMemoryReader();
+  SomPaletteSharedMemoryReader(const SomPaletteSharedMemoryReader&) = delete;
+  SomPaletteSharedMemoryReader& operator=(const SomPaletteSharedMemoryReader&) = delete;
+
+  // Returns false if the segment doesn't exist yet or isn't a palette segment; safe to retry.
+  bool open(const std::string& name);
+  void close();
+  bool isOpen() const { return header != nullptr; }
+
+  // Number of snapshots published so far; compare with the last value seen to detect new data.
+  uint64_t getGeneration() const { return header ? header->generation.load(std::memory_order_acquire) : 0; }
+
+  // Calls fn(const View&) on a consistent snapshot. fn may be called more than once if the
+  // publisher writes concurrently, so it should only read (or copy) from the view and must not
+  // act on the data until read() returns true. Returns false if nothing has been published or a
+  // consistent snapshot couldn't be obtained within maxAttempts.
+  template <typename F>
+  bool read(F&& fn, int maxAttempts = 16) const {
+    if (!header) return false;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+      const uint32_t before = header->sequence.load(std::memory_order_acquire);
+      if (before & 1u) continue; // write in progress
+      const uint64_t generation = header->generation.load(std::memory_order_relaxed);
+      if (generation == 0) return false;
+
+      const View view { header->width, header->height, pixels, header->palette, generation, header->publishMicros };
+      fn(view);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (header->sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+  }
+
+private:
+  int fd { -1 };
+  void* mapping { nullptr };
+  size_t mappingSize { 0 };
+  const SomPaletteSharedMemory::Header* header { nullptr };
+  const float* pixels { nullptr };
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <array>
+
+#include "ofMain.h"
+
+using SomPaletteColorsT = std::array<ofColor, 8>;
+
+// Receives each new palette snapshot from SomPalette / ContinuousSomPalette on the main thread,
+// e.g. to publish it to other processes or machines. Keep publish() cheap: it runs inside update().
+class SomPaletteSink {
+public:
+  virtual ~SomPaletteSink() = default;
+  virtual void publish(const ofFloatPixels& pixels, const SomPaletteColorsT& palette) = 0;
+};
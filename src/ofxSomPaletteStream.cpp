@@ -0,0 +1,242 @@
+#include "ofxSomPaletteStream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace SomPaletteStream {
+
+namespace {
+
+void put16(std::vector<uint8_t>& out, uint16_t v) {
+  out.push_back(static_cast<uint8_t>(v));
+  out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t v) {
+  for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+uint16_t get16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t get32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Wrap-safe "a is after b" for 32-bit counters.
+bool isAfter(uint32_t a, uint32_t b) {
+  return static_cast<int32_t>(a - b) > 0;
+}
+
+size_t bytesPerSample(FrameType type) {
+  return (type == FrameType::Keyframe) ? 2 : 1;
+}
+
+} // namespace
+
+bool readHeader(const uint8_t* data, size_t size, PacketHeader& header) {
+  if (size < headerBytes) return false;
+  if (get32(data) != magic || data[4] != version) return false;
+
+  header.type = static_cast<FrameType>(data[5]);
+  if (header.type != FrameType::Keyframe && header.type != FrameType::Delta) return false;
+  header.deltaShift = data[6];
+  if (header.deltaShift > 8) return false;
+  // data[7] reserved
+  header.chunkIndex = get16(data + 8);
+  header.chunkCount = get16(data + 10);
+  header.width = get16(data + 12);
+  header.height = get16(data + 14);
+  header.sampleCount = get16(data + 16);
+  header.sessionId = get16(data + 18);
+  header.sequence = get32(data + 20);
+  header.frameId = get32(data + 24);
+  header.baseFrameId = get32(data + 28);
+  header.sampleOffset = get32(data + 32);
+  std::memcpy(header.palette.data(), data + 36, paletteBytes);
+
+  const size_t numSamples = static_cast<size_t>(header.width) * header.height * 3;
+  if (header.chunkIndex >= header.chunkCount) return false;
+  if (header.sampleOffset + static_cast<size_t>(header.sampleCount) > numSamples) return false;
+  // Chunks must follow the encoder's split, which also caps a frame at chunkCount full payloads.
+  const size_t samplesPerChunk = maxPayloadBytes / bytesPerSample(header.type);
+  if (header.chunkCount != (numSamples + samplesPerChunk - 1) / samplesPerChunk) return false;
+  if (header.sampleOffset != header.chunkIndex * samplesPerChunk) return false;
+  if (size < headerBytes + header.sampleCount * bytesPerSample(header.type)) return false;
+  return true;
+}
+
+Encoder::Encoder(int keyframeInterval_, uint8_t deltaShift_, uint16_t sessionId_) :
+keyframeInterval { std::max(1, keyframeInterval_) },
+deltaShift { std::min<uint8_t>(deltaShift_, 8) },
+sessionId { sessionId_ }
+{}
+
+uint16_t Encoder::makeSessionId() {
+  std::random_device device;
+  return static_cast<uint16_t>(device());
+}
+
+void Encoder::encode(const float* rgb, uint16_t width_, uint16_t height_, const std::array<uint8_t, paletteBytes>& palette, std::vector<std::vector<uint8_t>>& packetsOut) {
+  const size_t numSamples = static_cast<size_t>(width_) * height_ * 3;
+  if (numSamples == 0) return;
+
+  const bool isKeyframe = isKeyframeRequested || width_ != width || height_ != height || framesSinceKeyframe + 1 >= keyframeInterval;
+  const uint32_t baseFrameId = frameId;
+  ++frameId;
+  width = width_;
+  height = height_;
+
+  if (isKeyframe) {
+    reference.resize(numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      reference[i] = static_cast<uint16_t>(std::lround(std::clamp(rgb[i], 0.0f, 1.0f) * 65535.0f));
+    }
+    framesSinceKeyframe = 0;
+    isKeyframeRequested = false;
+  } else {
+    // Closed-loop delta: quantize the change, then advance the reference exactly as the decoder will.
+    const int step = 1 << deltaShift;
+    deltas.resize(numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      const int target = static_cast<int>(std::lround(std::clamp(rgb[i], 0.0f, 1.0f) * 65535.0f));
+      const int diff = target - static_cast<int>(reference[i]);
+      const int q = std::clamp(static_cast<int>(std::lround(static_cast<float>(diff) / step)), -127, 127);
+      deltas[i] = static_cast<int8_t>(q);
+      reference[i] = static_cast<uint16_t>(std::clamp(static_cast<int>(reference[i]) + q * step, 0, 65535));
+    }
+    ++framesSinceKeyframe;
+  }
+
+  const FrameType type = isKeyframe ? FrameType::Keyframe : FrameType::Delta;
+  const size_t samplesPerChunk = maxPayloadBytes / bytesPerSample(type);
+  const size_t chunkCount = (numSamples + samplesPerChunk - 1) / samplesPerChunk;
+
+  for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+    const size_t offset = chunk * samplesPerChunk;
+    const size_t count = std::min(samplesPerChunk, numSamples - offset);
+
+    std::vector<uint8_t> packet;
+    packet.reserve(headerBytes + count * bytesPerSample(type));
+    put32(packet, magic);
+    packet.push_back(version);
+    packet.push_back(static_cast<uint8_t>(type));
+    packet.push_back(deltaShift);
+    packet.push_back(0);
+    put16(packet, static_cast<uint16_t>(chunk));
+    put16(packet, static_cast<uint16_t>(chunkCount));
+    put16(packet, width);
+    put16(packet, height);
+    put16(packet, static_cast<uint16_t>(count));
+    put16(packet, sessionId);
+    put32(packet, sequence++);
+    put32(packet, frameId);
+    put32(packet, isKeyframe ? frameId : baseFrameId);
+    put32(packet, static_cast<uint32_t>(offset));
+    packet.insert(packet.end(), palette.begin(), palette.end());
+
+    if (isKeyframe) {
+      for (size_t i = 0; i < count; ++i) put16(packet, reference[offset + i]);
+    } else {
+      for (size_t i = 0; i < count; ++i) packet.push_back(static_cast<uint8_t>(deltas[offset + i]));
+    }
+    packetsOut.push_back(std::move(packet));
+  }
+}
+
+bool Decoder::decode(const uint8_t* data, size_t size) {
+  PacketHeader header;
+  if (!readHeader(data, size, header)) return false;
+
+  if (hasSession && header.sessionId != sessionId) {
+    // A restarted sender: its frame ids and sequence numbers start again. Drop everything from the
+    // old session and wait for the new one's keyframe, keeping the last good frame meanwhile.
+    if (header.type != FrameType::Keyframe) return false;
+    currentFrameId = header.frameId - 1;
+    hasStaging = false;
+    hasSequence = false;
+  }
+  sessionId = header.sessionId;
+  hasSession = true;
+
+  if (hasSequence && isAfter(header.sequence, expectedSequence)) {
+    packetsLost += header.sequence - expectedSequence;
+  }
+  if (!hasSequence || isAfter(header.sequence + 1, expectedSequence)) {
+    expectedSequence = header.sequence + 1;
+    hasSequence = true;
+  }
+
+  // Old or duplicate frame
+  if (hasCurrentFrame && !isAfter(header.frameId, currentFrameId)) return false;
+
+  const bool isKeyframe = (header.type == FrameType::Keyframe);
+  const size_t numSamples = static_cast<size_t>(header.width) * header.height * 3;
+
+  if (!isKeyframe && (!hasCurrentFrame || header.baseFrameId != currentFrameId || header.width != width || header.height != height)) {
+    // Can't apply: we missed (part of) its base frame. Wait for the next keyframe.
+    if (lastDroppedFrameId != header.frameId || framesDropped == 0) {
+      lastDroppedFrameId = header.frameId;
+      ++framesDropped;
+    }
+    return false;
+  }
+
+  if (!hasStaging || stagingFrameId != header.frameId) {
+    // Abandon any older incomplete frame and start assembling this one.
+    if (hasStaging && stagingChunksReceived < stagingChunks.size()) ++framesDropped;
+    if (isKeyframe) staging.assign(numSamples, 0);
+    else staging = field;
+    stagingChunks.assign(header.chunkCount, 0);
+    stagingChunksReceived = 0;
+    stagingFrameId = header.frameId;
+    stagingType = header.type;
+    stagingWidth = header.width;
+    stagingHeight = header.height;
+    hasStaging = true;
+  }
+  // Every chunk must describe the frame being staged and land inside it.
+  if (header.type != stagingType || header.width != stagingWidth || header.height != stagingHeight) return false;
+  if (header.chunkCount != stagingChunks.size() || stagingChunks[header.chunkIndex]) return false;
+  if (header.sampleOffset + static_cast<size_t>(header.sampleCount) > staging.size()) return false;
+
+  const uint8_t* payload = data + headerBytes;
+  if (isKeyframe) {
+    for (size_t i = 0; i < header.sampleCount; ++i) {
+      staging[header.sampleOffset + i] = get16(payload + i * 2);
+    }
+  } else {
+    const int step = 1 << header.deltaShift;
+    for (size_t i = 0; i < header.sampleCount; ++i) {
+      const int q = static_cast<int8_t>(payload[i]);
+      uint16_t& sample = staging[header.sampleOffset + i];
+      sample = static_cast<uint16_t>(std::clamp(static_cast<int>(sample) + q * step, 0, 65535));
+    }
+  }
+  stagingChunks[header.chunkIndex] = 1;
+  ++stagingChunksReceived;
+
+  if (stagingChunksReceived < stagingChunks.size()) return false;
+
+  field.swap(staging);
+  width = stagingWidth;
+  height = stagingHeight;
+  palette = header.palette;
+  currentFrameId = header.frameId;
+  hasCurrentFrame = true;
+  hasStaging = false;
+  ++framesCompleted;
+  return true;
+}
+
+void Decoder::getFloatField(float* rgbOut) const {
+  constexpr float scale = 1.0f / 65535.0f;
+  for (size_t i = 0; i < field.size(); ++i) {
+    rgbOut[i] = static_cast<float>(field[i]) * scale;
+  }
+}
+
+} // namespace SomPaletteStream
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Wire format for streaming palette snapshots over UDP (see SomPaletteStreamSender/Receiver).
+//
+// Each snapshot is either a keyframe (every sample quantized to 16 bits) or a delta against the
+// previous snapshot (each sample's change quantized to a signed byte in steps of 1 << deltaShift).
+// The encoder tracks what the decoder will reconstruct (closed loop), so quantization error is
+// corrected by the next delta instead of accumulating. A delta moves each sample by at most
+// 127 << deltaShift (of 65535) per frame, about 0.12 at the default shift of 6, so a larger jump
+// is reached over several frames, or at once by the next keyframe.
+//
+// Snapshots are split into chunks that fit a typical MTU. Every packet carries a sequence number,
+// its frame id, the frame a delta applies to, and the 8-colour palette. A delta can only be applied
+// on top of exactly its base frame, so after any loss the decoder waits for the next keyframe;
+// the encoder sends one every keyframeInterval frames. Each encoder also stamps a random session
+// id, so when a sender restarts (and its frame ids start again) its first keyframe resyncs the
+// decoder instead of being discarded as old.
+//
+// All multi-byte fields are little-endian.
+//
+// The codec has no dependencies. SomPaletteStreamSender/Receiver need ofxNetwork and compile to
+// nothing in projects that don't include it.
+#if __has_include("ofxNetwork.h")
+#define OFX_SOM_PALETTE_STREAM_NETWORK
+#endif
+
+namespace SomPaletteStream {
+
+constexpr uint32_t magic = 0x534f4d55; // "SOMU"
+constexpr uint8_t version = 2;
+constexpr size_t paletteBytes = 8 * 3;
+constexpr size_t headerBytes = 36 + paletteBytes;
+constexpr size_t maxPayloadBytes = 1200;
+
+enum class FrameType : uint8_t { Keyframe = 0, Delta = 1 };
+
+struct PacketHeader {
+  FrameType type;
+  uint8_t deltaShift;
+  uint16_t chunkIndex;
+  uint16_t chunkCount;
+  uint16_t width;
+  uint16_t height;
+  uint16_t sampleCount;
+  uint16_t sessionId;
+  uint32_t sequence;
+  uint32_t frameId;
+  uint32_t baseFrameId; // == frameId for keyframes
+  uint32_t sampleOffset;
+  std::array<uint8_t, paletteBytes> palette;
+};
+
+// Returns false if the buffer isn't a well-formed packet of this version.
+bool readHeader(const uint8_t* data, size_t size, PacketHeader& header);
+
+class Encoder {
+public:
+  explicit Encoder(int keyframeInterval_ = 30, uint8_t deltaShift_ = 6, uint16_t sessionId_ = makeSessionId());
+  static uint16_t makeSessionId(); // random
+
+  // Appends the packets for one snapshot (packed RGB floats in [0..1], palette as RGB bytes).
+  void encode(const float* rgb, uint16_t width, uint16_t height, const std::array<uint8_t, paletteBytes>& palette, std::vector<std::vector<uint8_t>>& packetsOut);
+  void requestKeyframe() { isKeyframeRequested = true; }
+
+private:
+  int keyframeInterval;
+  uint8_t deltaShift;
+  uint16_t sessionId;
+  std::vector<uint16_t> reference; // what the decoder holds after the last frame
+  uint16_t width { 0 }, height { 0 };
+  uint32_t frameId { 0 };
+  uint32_t sequence { 0 };
+  int framesSinceKeyframe { 0 };
+  bool isKeyframeRequested { true };
+  std::vector<int8_t> deltas; // scratch
+};
+
+class Decoder {
+public:
+  // Returns true when this packet completed a frame, i.e. the reconstructed field changed.
+  bool decode(const uint8_t* data, size_t size);
+
+  bool hasFrame() const { return hasCurrentFrame; }
+  uint16_t getWidth() const { return width; }
+  uint16_t getHeight() const { return height; }
+  const std::vector<uint16_t>& getField() const { return field; } // width * height * 3 samples
+  const std::array<uint8_t, paletteBytes>& getPalette() const { return palette; }
+  void getFloatField(float* rgbOut) const;
+
+  uint64_t getPacketsLost() const { return packetsLost; }
+  uint64_t getFramesCompleted() const { return framesCompleted; }
+  uint64_t getFramesDropped() const { return framesDropped; }
+
+private:
+  std::vector<uint16_t> field;
+  uint16_t width { 0 }, height { 0 };
+  std::array<uint8_t, paletteBytes> palette {};
+  uint32_t currentFrameId { 0 };
+  bool hasCurrentFrame { false };
+  uint16_t sessionId { 0 };
+  bool hasSession { false };
+
+  // Frame being assembled from chunks
+  std::vector<uint16_t> staging;
+  std::vector<uint8_t> stagingChunks;
+  uint32_t stagingFrameId { 0 };
+  FrameType stagingType { FrameType::Keyframe };
+  uint16_t stagingWidth { 0 }, stagingHeight { 0 };
+  bool hasStaging { false };
+  size_t stagingChunksReceived { 0 };
+
+  uint32_t expectedSequence { 0 };
+  bool hasSequence { false };
+  uint32_t lastDroppedFrameId { 0 };
+  uint64_t packetsLost { 0 };
+  uint64_t framesCompleted { 0 };
+  uint64_t framesDropped { 0 };
+};
+
+} // namespace SomPaletteStream
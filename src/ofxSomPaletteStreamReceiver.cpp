@@ -0,0 +1,71 @@
+#include "ofxSomPaletteStreamReceiver.h"
+#include "ofTexture.h"
+
+#ifdef OFX_SOM_PALETTE_STREAM_NETWORK
+
+SomPaletteStreamReceiver::SomPaletteStreamReceiver(unsigned short port) :
+buffer(65536)
+{
+  palette.fill(ofColor::black);
+  isBound = udp.Create() && udp.Bind(port);
+  if (!isBound) {
+    ofLogError("SomPaletteStreamReceiver") << "can't bind UDP socket to port " << port;
+    return;
+  }
+  udp.SetNonBlocking(true);
+  udp.SetReceiveBufferSize(1 << 20); // a few seconds of keyframes, in case the app stalls
+}
+
+void SomPaletteStreamReceiver::update() {
+  isNewFrame = false;
+  if (!isBound) return;
+
+  int received;
+  while ((received = udp.Receive(reinterpret_cast<char*>(buffer.data()), static_cast<int>(buffer.size()))) > 0) {
+    if (decoder.decode(buffer.data(), static_cast<size_t>(received))) isNewFrame = true;
+  }
+  if (!isNewFrame) return;
+
+  const size_t width = decoder.getWidth();
+  const size_t height = decoder.getHeight();
+  if (pixels.getWidth() != width || pixels.getHeight() != height) {
+    pixels.allocate(width, height, 3);
+    texture.clear();
+  }
+  decoder.getFloatField(pixels.getData());
+
+  if (!texture.isAllocated()) {
+    texture.allocate(pixels, false);
+    texture.setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
+    texture.setTextureWrap(GL_MIRRORED_REPEAT, GL_MIRRORED_REPEAT);
+  }
+  texture.loadData(pixels);
+
+  const auto& bytes = decoder.getPalette();
+  for (size_t i = 0; i < palette.size(); ++i) {
+    palette[i] = ofColor(bytes[i * 3], bytes[i * 3 + 1], bytes[i * 3 + 2]);
+  }
+}
+
+ofColor SomPaletteStreamReceiver::getColorAt(int x, int y) const {
+  if (!texture.isAllocated()) return ofColor::black;
+  return pixels.getColor(x, y);
+}
+
+void SomPaletteStreamReceiver::draw(bool paletteOnly) {
+  ofPushStyle();
+  ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+  ofSetColor(255);
+  if (!paletteOnly && texture.isAllocated()) {
+    texture.draw(0, 0, 1.0, 1.0);
+  }
+  float chipWidth = 1.0 / palette.size();
+  ofFill();
+  for (size_t i = 0; i < palette.size(); i++) {
+    ofSetColor(getColor(i));
+    ofDrawRectangle(i*chipWidth, 0.0, chipWidth, chipWidth / 2.0);
+  }
+  ofPopStyle();
+}
+
+#endif // OFX_SOM_PALETTE_STREAM_NETWORK
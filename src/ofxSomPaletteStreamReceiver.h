@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ofxSomPaletteStream.h"
+
+#ifdef OFX_SOM_PALETTE_STREAM_NETWORK
+
+#include <array>
+#include <vector>
+
+#include "ofMain.h"
+#include "ofxNetwork.h"
+
+// Reconstructs palette snapshots streamed by a SomPaletteStreamSender, exposing the same read API
+// as SomPalette (pixels, texture, palette colours). Call update() once per frame on the main thread.
+class SomPaletteStreamReceiver {
+public:
+  explicit SomPaletteStreamReceiver(unsigned short port);
+
+  void update();
+  bool isNewFrameReady() const { return isNewFrame; }
+  bool hasFrame() const { return decoder.hasFrame(); }
+
+  const ofFloatPixels& getPixelsRef() const { return pixels; }
+  const ofTexture& getTexture() const { return texture; }
+  ofColor getColorAt(int x, int y) const;
+  ofColor getColor(int i) const { return palette[i]; }
+  void draw(bool paletteOnly = false);
+
+  uint64_t getPacketsLost() const { return decoder.getPacketsLost(); }
+  uint64_t getFramesReceived() const { return decoder.getFramesCompleted(); }
+  uint64_t getFramesDropped() const { return decoder.getFramesDropped(); }
+
+private:
+  ofxUDPManager udp;
+  bool isBound { false };
+  SomPaletteStream::Decoder decoder;
+  std::vector<uint8_t> buffer;
+  bool isNewFrame { false };
+
+  ofFloatPixels pixels;
+  ofTexture texture;
+  std::array<ofColor, 8> palette;
+};
+
+#endif // OFX_SOM_PALETTE_STREAM_NETWORK
@@ -0,0 +1,37 @@
+#include "ofxSomPaletteStreamSender.h"
+
+#ifdef OFX_SOM_PALETTE_STREAM_NETWORK
+
+SomPaletteStreamSender::SomPaletteStreamSender(const std::string& host, unsigned short port, int keyframeInterval) :
+encoder { keyframeInterval }
+{
+  isConnected = udp.Create() && udp.Connect(host.c_str(), port);
+  if (!isConnected) {
+    ofLogError("SomPaletteStreamSender") << "can't connect UDP socket to " << host << ":" << port;
+    return;
+  }
+  udp.SetNonBlocking(true);
+}
+
+void SomPaletteStreamSender::publish(const ofFloatPixels& pixels, const SomPaletteColorsT& palette) {
+  if (!isConnected || pixels.getNumChannels() != 3) return;
+
+  std::array<uint8_t, SomPaletteStream::paletteBytes> paletteBytes;
+  for (size_t i = 0; i < palette.size(); ++i) {
+    paletteBytes[i * 3] = palette[i].r;
+    paletteBytes[i * 3 + 1] = palette[i].g;
+    paletteBytes[i * 3 + 2] = palette[i].b;
+  }
+
+  packets.clear();
+  encoder.encode(pixels.getData(), static_cast<uint16_t>(pixels.getWidth()), static_cast<uint16_t>(pixels.getHeight()), paletteBytes, packets);
+
+  for (const auto& packet : packets) {
+    const int sent = udp.Send(reinterpret_cast<const char*>(packet.data()), static_cast<int>(packet.size()));
+    if (sent <= 0) continue; // non-blocking: dropped like any other lost packet
+    bytesSent += sent;
+    ++packetsSent;
+  }
+}
+
+#endif // OFX_SOM_PALETTE_STREAM_NETWORK
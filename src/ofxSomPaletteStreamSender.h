@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ofxSomPaletteStream.h"
+
+#ifdef OFX_SOM_PALETTE_STREAM_NETWORK
+
+#include <string>
+#include <vector>
+
+#include "ofMain.h"
+#include "ofxNetwork.h"
+#include "ofxSomPaletteSink.h"
+
+// Streams each palette snapshot over UDP to a SomPaletteStreamReceiver, as keyframes plus
+// quantized deltas (see ofxSomPaletteStream.h for the wire format).
+//
+//   auto sender = std::make_shared<SomPaletteStreamSender>("192.168.1.20", 9100);
+//   somPalette.addSink(sender);
+//
+// A 16x16 palette costs ~0.8KB per delta frame instead of ~3KB raw floats. A lost packet leaves the
+// receiver on its last good frame until the next keyframe, so keyframeInterval bounds recovery time.
+class SomPaletteStreamSender: public SomPaletteSink {
+public:
+  SomPaletteStreamSender(const std::string& host, unsigned short port, int keyframeInterval = 30);
+
+  void publish(const ofFloatPixels& pixels, const SomPaletteColorsT& palette) override;
+  void requestKeyframe() { encoder.requestKeyframe(); }
+
+  uint64_t getBytesSent() const { return bytesSent; }
+  uint64_t getPacketsSent() const { return packetsSent; }
+
+private:
+  ofxUDPManager udp;
+  bool isConnected { false };
+  SomPaletteStream::Encoder encoder;
+  std::vector<std::vector<uint8_t>> packets;
+  uint64_t bytesSent { 0 };
+  uint64_t packetsSent { 0 };
+};
+
+#endif // OFX_SOM_PALETTE_STREAM_NETWORK
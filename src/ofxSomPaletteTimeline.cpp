@@ -0,0 +1,130 @@
+#include "ofxSomPaletteTimeline.h"
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+
+namespace {
+
+// ofxSelfOrganizingMap::setup draws its (immediately overwritten) weights from ofRandom's shared
+// engine, which isn't safe to use from several timelines at once.
+std::mutex backendSetupMutex;
+
+} // namespace
+
+SomPaletteTimeline::SomPaletteTimeline(const SomPaletteTimelineSettings& settings_)
+: settings { settings_ }
+{
+  settings.windowFrames = std::max(2, settings.windowFrames);
+  hopFrames = std::max(1, settings.windowFrames / 2);
+
+  for (auto& map : maps) {
+    resetMap(map);
+  }
+
+  blendedPixels.allocate(settings.width, settings.height, OF_IMAGE_COLOR);
+  blendedPixels.set(0.0f);
+}
+
+void SomPaletteTimeline::resetMap(Map& map) {
+  {
+    std::lock_guard<std::mutex> lock(backendSetupMutex);
+    map.som = makeSomBackend(settings.backend);
+    map.som->setup(settings.width, settings.height, settings.initialLearningRate, settings.numIterations);
+  }
+
+  std::seed_seq seq { settings.seed, mapsCreated++ };
+  std::mt19937 rng(seq);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+  weights.resize(static_cast<size_t>(settings.width) * static_cast<size_t>(settings.height) * 3);
+  for (auto& w : weights) {
+    w = uniform(rng);
+  }
+  map.som->writeWeights(weights);
+
+  map.shouldWarmStart = true;
+  map.isTrainedSinceColorize = false;
+  // Like a new SomPalette: black until first colorized, and blended in as black until then.
+  map.pixels.assign(weights.size(), 0.0f);
+  map.palette.fill(ofColor::black);
+}
+
+void SomPaletteTimeline::addInstanceData(const SomInstanceDataT& instanceData) {
+  trainMap(maps[blendFromIndex], instanceData);
+  trainMap(maps[blendToIndex], instanceData);
+}
+
+void SomPaletteTimeline::trainMap(Map& map, const SomInstanceDataT& instanceData) {
+  // SomPalette stops accepting instances once its iterations are used up.
+  if (map.som->getCurrentIteration() >= map.som->getNumIterations()) return;
+
+  if (map.shouldWarmStart) {
+    map.som->readWeights(weights);
+    SomPalette::warmStartWeights(weights, settings.width, settings.height, instanceData, settings.warmStartMix);
+    map.som->writeWeights(weights);
+    map.shouldWarmStart = false;
+  }
+  map.som->updateMap(instanceData);
+  map.isTrainedSinceColorize = true;
+}
+
+void SomPaletteTimeline::colorizeMap(Map& map) {
+  const size_t numCells = static_cast<size_t>(settings.width) * static_cast<size_t>(settings.height);
+  map.som->readWeights(weights);
+  map.pixels.resize(numCells * 3);
+  settings.colorizer.colorize(weights.data(), map.pixels.data(), numCells);
+  SomPalette::extractPalette(map.pixels.data(), numCells, map.palette);
+  map.isTrainedSinceColorize = false;
+}
+
+void SomPaletteTimeline::advanceFrame() {
+  // Same order as ContinuousSomPalette::update.
+  ++frameCount;
+
+  while (frameCount - lastHopFrameCount >= hopFrames) {
+    performHop();
+  }
+
+  for (auto& map : maps) {
+    if (map.isTrainedSinceColorize) colorizeMap(map);
+  }
+
+  updateBlendedPixels();
+}
+
+void SomPaletteTimeline::performHop() {
+  lastHopFrameCount = frameCount;
+
+  blendFromIndex = blendToIndex;
+  blendToIndex = (blendFromIndex + 1) % maps.size();
+
+  resetMap(maps[blendToIndex]);
+  ++hopCount;
+}
+
+float SomPaletteTimeline::getBlendAlpha() const {
+  float t = static_cast<float>(frameCount - lastHopFrameCount) / static_cast<float>(hopFrames);
+  t = ofClamp(t, 0.0f, 1.0f);
+  return t * t * (3.0f - 2.0f * t);
+}
+
+void SomPaletteTimeline::updateBlendedPixels() {
+  const Map& a = maps[blendFromIndex];
+  const Map& b = maps[blendToIndex];
+  const float alpha = getBlendAlpha();
+  float* dst = blendedPixels.getData();
+  const size_t n = a.pixels.size();
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = ofLerp(a.pixels[i], b.pixels[i], alpha);
+  }
+}
+
+ofColor SomPaletteTimeline::getColor(int i) const {
+  return maps[blendFromIndex].palette[i].getLerped(maps[blendToIndex].palette[i], getBlendAlpha());
+}
+
+void SomPaletteTimeline::getPalette(SomPaletteColorsT& paletteOut) const {
+  for (size_t i = 0; i < paletteOut.size(); ++i) {
+    paletteOut[i] = getColor(static_cast<int>(i));
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ofMain.h"
+#include "ofxSomBackend.h"
+#include "ofxSomColorizer.h"
+#include "ofxSomPalette.h"
+#include "ofxSomPaletteSink.h"
+
+struct SomPaletteTimelineSettings {
+  int width { 16 };
+  int height { 16 };
+  float initialLearningRate { 0.015f };
+  int numIterations { 4000 };
+  int windowFrames { 450 }; // as ContinuousSomPalette::setWindowFrames
+  SomColorizer colorizer; // gains 1.0 / 1.25 unless changed, as ContinuousSomPalette
+  float warmStartMix { 0.60f };
+  SomBackendType backend { SomBackendType::Float };
+  uint32_t seed { 1 }; // initial weights of every map derive from this
+};
+
+// Offline equivalent of ContinuousSomPalette: the same two overlapping maps, warm start, hop
+// cadence, colorizer and crossfade, but trained synchronously on the calling thread with no
+// worker, channels or textures. Instances added between two advanceFrame() calls belong to that
+// frame, as if they had all arrived before ContinuousSomPalette::update().
+//
+// Map weights start from a seeded generator rather than ofRandom, so the same instances and
+// settings always give the same frames. Independent timelines can run on separate threads.
+// Coarse-to-fine training and idle detection are not modelled.
+class SomPaletteTimeline {
+public:
+  explicit SomPaletteTimeline(const SomPaletteTimelineSettings& settings = {});
+
+  void addInstanceData(const SomInstanceDataT& instanceData);
+  // Ends the current frame: hops if due, colorizes maps trained since the last frame and blends.
+  void advanceFrame();
+
+  const ofFloatPixels& getPixelsRef() const { return blendedPixels; }
+  ofColor getColor(int i) const;
+  void getPalette(SomPaletteColorsT& paletteOut) const;
+
+  int64_t getFrameCount() const { return frameCount; }
+  uint64_t getHopCount() const { return hopCount; }
+  const SomPaletteTimelineSettings& getSettings() const { return settings; }
+
+private:
+  struct Map {
+    std::unique_ptr<SomBackend> som;
+    bool shouldWarmStart { true };
+    bool isTrainedSinceColorize { false };
+    std::vector<float> pixels; // packed RGB, width * height; zero until first colorized
+    std::array<ofColor, SomPalette::size> palette;
+  };
+
+  SomPaletteTimelineSettings settings;
+  int hopFrames;
+  std::array<Map, 2> maps;
+  int blendFromIndex { 0 };
+  int blendToIndex { 1 };
+  int64_t frameCount { 0 };
+  int64_t lastHopFrameCount { 0 };
+  uint64_t hopCount { 0 };
+  uint32_t mapsCreated { 0 };
+
+  std::vector<float> weights; // scratch
+  ofFloatPixels blendedPixels;
+
+  void resetMap(Map& map);
+  void trainMap(Map& map, const SomInstanceDataT& instanceData);
+  void colorizeMap(Map& map);
+  void performHop();
+  float getBlendAlpha() const;
+  void updateBlendedPixels();
+};
@@ -0,0 +1,182 @@
+#include "ofxSomPaletteTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace SomPaletteTrace {
+
+namespace {
+
+// A seqlock per slot: `sequence` is the event's index + 1 once written and 0 while the owning
+// thread is overwriting it. Fields are relaxed atomics so the exporter can read them concurrently
+// and discard any slot whose sequence changed underneath it.
+struct Event {
+  std::atomic<uint64_t> sequence { 0 };
+  std::atomic<const char*> name { nullptr };
+  std::atomic<uint64_t> startMicros { 0 };
+  std::atomic<uint64_t> durationMicros { 0 };
+};
+
+// One per thread. Only the owning thread writes; the exporter reads whatever has been committed.
+struct ThreadBuffer {
+  static constexpr size_t capacity = 1 << 14; // oldest events are overwritten
+
+  explicit ThreadBuffer(int tid_) : tid { tid_ }, events(capacity) {}
+
+  const int tid;
+  std::string name;
+  std::vector<Event> events;
+  std::atomic<uint64_t> committed { 0 };
+  std::atomic<uint64_t> clearedAt { 0 }; // export ignores events before this
+  std::atomic<bool> retired { false };
+};
+
+// SomPalette workers come and go with every hop, so only a few finished threads' buffers are kept.
+constexpr size_t maxRetiredBuffers = 16;
+
+struct Registry {
+  std::mutex mutex;
+  std::deque<std::shared_ptr<ThreadBuffer>> buffers;
+  int nextTid { 1 };
+};
+
+Registry& registry() {
+  static Registry r;
+  return r;
+}
+
+const std::chrono::steady_clock::time_point& epoch() {
+  static const std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+  return t;
+}
+
+// Registers on first use and retires the buffer when the thread exits.
+struct ThreadBufferHandle {
+  ThreadBufferHandle() {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    buffer = std::make_shared<ThreadBuffer>(r.nextTid++);
+    r.buffers.push_back(buffer);
+  }
+
+  ~ThreadBufferHandle() {
+    buffer->retired.store(true);
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    size_t numRetired = std::count_if(r.buffers.begin(), r.buffers.end(), [](const auto& b) { return b->retired.load(); });
+    for (auto it = r.buffers.begin(); it != r.buffers.end() && numRetired > maxRetiredBuffers;) {
+      if ((*it)->retired.load()) {
+        it = r.buffers.erase(it);
+        --numRetired;
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  std::shared_ptr<ThreadBuffer> buffer;
+};
+
+ThreadBuffer& threadBuffer() {
+  thread_local ThreadBufferHandle handle;
+  return *handle.buffer;
+}
+
+void writeJsonString(std::ostream& out, const std::string& s) {
+  out << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') out << '\\' << c;
+    else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+    else out << c;
+  }
+  out << '"';
+}
+
+} // namespace
+
+uint64_t nowMicros() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch()).count());
+}
+
+void record(const char* name, uint64_t startMicros, uint64_t durationMicros) {
+  ThreadBuffer& b = threadBuffer();
+  const uint64_t n = b.committed.load(std::memory_order_relaxed);
+  Event& e = b.events[n % ThreadBuffer::capacity];
+  e.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  e.name.store(name, std::memory_order_relaxed);
+  e.startMicros.store(startMicros, std::memory_order_relaxed);
+  e.durationMicros.store(durationMicros, std::memory_order_relaxed);
+  e.sequence.store(n + 1, std::memory_order_release);
+  b.committed.store(n + 1, std::memory_order_release);
+}
+
+void setThreadName(const std::string& name) {
+  ThreadBuffer& b = threadBuffer();
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  b.name = name;
+}
+
+bool writeChromeTrace(const std::string& path) {
+  std::ofstream out(path);
+  if (!out) return false;
+
+  auto& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  out << "{\"traceEvents\":[\n";
+  bool first = true;
+  auto separator = [&]() {
+    if (!first) out << ",\n";
+    first = false;
+  };
+
+  for (const auto& b : r.buffers) {
+    if (!b->name.empty()) {
+      separator();
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid << ",\"args\":{\"name\":";
+      writeJsonString(out, b->name);
+      out << "}}";
+    }
+
+    // The owning thread may still be writing: a slot only counts if it holds event i before and
+    // after its fields are read, otherwise it has been (or is being) overwritten by a newer event.
+    const uint64_t committed = b->committed.load(std::memory_order_acquire);
+    const uint64_t available = std::min<uint64_t>(committed, ThreadBuffer::capacity);
+    const uint64_t begin = std::max(committed - available, b->clearedAt.load());
+    for (uint64_t i = begin; i < committed; ++i) {
+      const Event& e = b->events[i % ThreadBuffer::capacity];
+      if (e.sequence.load(std::memory_order_acquire) != i + 1) continue;
+      const char* name = e.name.load(std::memory_order_relaxed);
+      const uint64_t startMicros = e.startMicros.load(std::memory_order_relaxed);
+      const uint64_t durationMicros = e.durationMicros.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (e.sequence.load(std::memory_order_relaxed) != i + 1) continue;
+
+      separator();
+      out << "{\"name\":";
+      writeJsonString(out, name ? name : "");
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid << ",\"ts\":" << startMicros << ",\"dur\":" << durationMicros << "}";
+    }
+  }
+
+  out << "\n]}\n";
+  return static_cast<bool>(out);
+}
+
+void clear() {
+  auto& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.buffers.erase(std::remove_if(r.buffers.begin(), r.buffers.end(), [](const auto& b) { return b->retired.load(); }), r.buffers.end());
+  for (auto& b : r.buffers) {
+    // The writer owns `committed`, so clearing just moves the export watermark.
+    b->clearedAt.store(b->committed.load(std::memory_order_acquire));
+  }
+}
+
+} // namespace SomPaletteTrace
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Timeline tracing for the palette worker and main threads.
+//
+// Zones are compiled out unless OFX_SOM_PALETTE_TRACE is defined (e.g. via ADDON_DEFINES or the
+// project's compiler flags). When enabled, each thread records into its own fixed-size ring with a
+// single writer and no locks; writeChromeTrace() exports everything recorded so far as Chrome
+// trace-event JSON, which loads in chrome://tracing or ui.perfetto.dev.
+//
+//   SOM_PALETTE_TRACE_ZONE("SomPalette::updateMap");
+//   ...
+//   SomPaletteTrace::writeChromeTrace(ofToDataPath("palette-trace.json"));
+namespace SomPaletteTrace {
+
+constexpr bool isCompiledIn() {
+#ifdef OFX_SOM_PALETTE_TRACE
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t nowMicros();
+void record(const char* name, uint64_t startMicros, uint64_t durationMicros);
+void setThreadName(const std::string& name);
+// Returns false if the file couldn't be written.
+bool writeChromeTrace(const std::string& path);
+void clear();
+
+class Zone {
+public:
+  explicit Zone(const char* name_) : name { name_ }, startMicros { nowMicros() } {}
+  ~Zone() { record(name, startMicros, nowMicros() - startMicros); }
+  Zone(const Zone&) = delete;
+  Zone& operator=(const Zone&) = delete;
+
+private:
+  const char* name; // must be a string literal (or otherwise outlive the export)
+  uint64_t startMicros;
+};
+
+} // namespace SomPaletteTrace
+
+#define SOM_PALETTE_TRACE_CONCAT_INNER(a, b) a##b
+#define SOM_PALETTE_TRACE_CONCAT(a, b) SOM_PALETTE_TRACE_CONCAT_INNER(a, b)
+
+#ifdef OFX_SOM_PALETTE_TRACE
+#define SOM_PALETTE_TRACE_ZONE(name) SomPaletteTrace::Zone SOM_PALETTE_TRACE_CONCAT(somPaletteTraceZone, __LINE__) { name }
+#define SOM_PALETTE_TRACE_THREAD_NAME(name) SomPaletteTrace::setThreadName(name)
+#else
+#define SOM_PALETTE_TRACE_ZONE(name) do {} while (0)
+#define SOM_PALETTE_TRACE_THREAD_NAME(name) do {} while (0)
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded single-producer/single-consumer ring.
+//
+// One thread pushes, one thread pops; neither ever blocks or takes a lock.
+// Capacity is rounded up to a power of two. A full ring rejects the push (the caller decides
+// whether dropping is acceptable) rather than overwriting data the consumer hasn't seen.
+template <typename T>
+class SomRingBuffer {
+public:
+  explicit SomRingBuffer(size_t capacity_ = 256)
+  : capacity { roundUpToPowerOfTwo(capacity_) }
+  , mask { capacity - 1 }
+  , slots { std::make_unique<T[]>(capacity) }
+  {}
+
+  SomRingBuffer(const SomRingBuffer&) = delete;
+  SomRingBuffer& operator=(const SomRingBuffer&) = delete;
+
+  // Producer side.
+  bool push(const T& value) {
+    if (isFull()) return false;
+    const size_t head = writeIndex.load(std::memory_order_relaxed);
+    slots[head & mask] = value;
+    writeIndex.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Producer side. value is only moved from if the push succeeds.
+  bool push(T&& value) {
+    if (isFull()) return false;
+    const size_t head = writeIndex.load(std::memory_order_relaxed);
+    slots[head & mask] = std::move(value);
+    writeIndex.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side.
+  bool pop(T& value) {
+    const size_t tail = readIndex.load(std::memory_order_relaxed);
+    if (tail == cachedWriteIndex) {
+      cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+      if (tail == cachedWriteIndex) return false;
+    }
+    value = std::move(slots[tail & mask]);
+    readIndex.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side: discard everything currently queued.
+  void clear() {
+    // Refresh the cached write index too, or the next pop would read the slot at the new tail.
+    const size_t head = writeIndex.load(std::memory_order_acquire);
+    cachedWriteIndex = head;
+    readIndex.store(head, std::memory_order_release);
+  }
+
+  // Approximate when called from a third thread; exact from either endpoint.
+  size_t sizeApprox() const {
+    return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+  }
+
+  size_t getCapacity() const { return capacity; }
+
+private:
+  // Producer side.
+  bool isFull() {
+    const size_t head = writeIndex.load(std::memory_order_relaxed);
+    if (head - cachedReadIndex < capacity) return false;
+    cachedReadIndex = readIndex.load(std::memory_order_acquire);
+    return head - cachedReadIndex >= capacity;
+  }
+
+  static size_t roundUpToPowerOfTwo(size_t n) {
+    size_t p = 2;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+  const size_t capacity;
+  const size_t mask;
+  std::unique_ptr<T[]> slots;
+
+  // Producer and consumer indices live on separate cache lines to avoid false sharing.
+  alignas(64) std::atomic<size_t> writeIndex { 0 };
+  size_t cachedReadIndex { 0 }; // producer-only
+  alignas(64) std::atomic<size_t> readIndex { 0 };
+  size_t cachedWriteIndex { 0 }; // consumer-only
+};
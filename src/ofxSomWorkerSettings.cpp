@@ -0,0 +1,132 @@
+#include "ofxSomWorkerSettings.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+void appendError(std::string& error, const std::string& what, int err) {
+  if (!error.empty()) error += "; ";
+  error += what + ": " + std::strerror(err);
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+
+int toNativePolicy(SomWorkerSettings::Policy policy) {
+  switch (policy) {
+    case SomWorkerSettings::Policy::RoundRobin: return SCHED_RR;
+    case SomWorkerSettings::Policy::Fifo: return SCHED_FIFO;
+#if defined(__linux__)
+    case SomWorkerSettings::Policy::Batch: return SCHED_BATCH;
+    case SomWorkerSettings::Policy::Idle: return SCHED_IDLE;
+#endif
+    default: return SCHED_OTHER;
+  }
+}
+
+std::string policyName(int nativePolicy) {
+  switch (nativePolicy) {
+    case SCHED_RR: return "round-robin";
+    case SCHED_FIFO: return "fifo";
+#if defined(__linux__)
+    case SCHED_BATCH: return "batch";
+    case SCHED_IDLE: return "idle";
+#endif
+    case SCHED_OTHER: return "default";
+    default: return "unknown";
+  }
+}
+
+#endif
+
+} // namespace
+
+SomWorkerStatus applySomWorkerSettings(const SomWorkerSettings& settings) {
+  std::string error;
+
+#if defined(__linux__) || defined(__APPLE__)
+  const int nativePolicy = toNativePolicy(settings.policy);
+  const bool isRealtime = (nativePolicy == SCHED_RR || nativePolicy == SCHED_FIFO);
+
+  sched_param param {};
+  param.sched_priority = isRealtime ? settings.realtimePriority : 0;
+  if (int err = pthread_setschedparam(pthread_self(), nativePolicy, &param)) {
+    appendError(error, "scheduling policy", err);
+  }
+
+#if defined(__linux__)
+  // On Linux the nice value of a thread id is per-thread (it doesn't touch the rest of the process).
+  if (!isRealtime) {
+    const id_t tid = static_cast<id_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, tid, settings.niceLevel) != 0) {
+      appendError(error, "nice level", errno);
+    }
+  }
+
+  if (settings.cpuAffinityMask != 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+      if (settings.cpuAffinityMask & (uint64_t { 1 } << cpu)) CPU_SET(cpu, &cpus);
+    }
+    if (int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+      appendError(error, "cpu affinity", err);
+    }
+  }
+#else
+  if (settings.niceLevel != 0) appendError(error, "nice level", ENOTSUP);
+  if (settings.cpuAffinityMask != 0) appendError(error, "cpu affinity", ENOTSUP);
+#endif
+
+#else
+  if (settings.policy != SomWorkerSettings::Policy::Default || settings.niceLevel != 0 || settings.cpuAffinityMask != 0) {
+    appendError(error, "worker scheduling", ENOTSUP);
+  }
+#endif
+
+  SomWorkerStatus status = querySomWorkerStatus();
+  status.applied = true;
+  status.error = error;
+  return status;
+}
+
+SomWorkerStatus querySomWorkerStatus() {
+  SomWorkerStatus status;
+
+#if defined(__linux__) || defined(__APPLE__)
+  int nativePolicy = SCHED_OTHER;
+  sched_param param {};
+  if (pthread_getschedparam(pthread_self(), &nativePolicy, &param) == 0) {
+    status.policy = policyName(nativePolicy);
+    status.realtimePriority = param.sched_priority;
+  }
+#endif
+
+#if defined(__linux__)
+  const id_t tid = static_cast<id_t>(syscall(SYS_gettid));
+  errno = 0;
+  const int nice = getpriority(PRIO_PROCESS, tid);
+  if (errno == 0) status.niceLevel = nice;
+
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0) {
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpus)) status.cpuAffinityMask |= (uint64_t { 1 } << cpu);
+    }
+  }
+#endif
+
+  return status;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Scheduling controls for SOM worker threads, so they don't compete with audio analysis or rendering.
+//
+// Applied by the worker to itself (scheduling and affinity are per-thread). Anything the platform
+// refuses (e.g. realtime policies without privileges) is left as-is and reported in SomWorkerStatus.
+struct SomWorkerSettings {
+  enum class Policy { Default, Batch, Idle, RoundRobin, Fifo };
+
+  Policy policy { Policy::Default };
+  int realtimePriority { 0 }; // RoundRobin/Fifo only
+  int niceLevel { 0 }; // Default/Batch only; Linux applies it per-thread
+  uint64_t cpuAffinityMask { 0 }; // bit n = CPU n; 0 leaves affinity alone
+
+  // Training budget: at most trainingBudgetMillis of work per tickMillis window. Instances arriving
+  // after the budget is spent are dropped, and publishing is deferred to once per tick.
+  // 0 means unlimited (train and publish every instance as it arrives).
+  float trainingBudgetMillis { 0.0f };
+  float tickMillis { 16.0f };
+};
+
+// What the worker thread actually ended up with.
+struct SomWorkerStatus {
+  bool applied { false };
+  std::string policy { "unknown" };
+  int realtimePriority { 0 };
+  int niceLevel { 0 };
+  uint64_t cpuAffinityMask { 0 };
+  std::string error; // empty if every requested setting took effect
+
+  uint64_t deferredPublishes { 0 }; // publishes postponed to the end of a tick
+  uint64_t decimatedInstances { 0 }; // instances dropped because the tick's budget was spent
+};
+
+// Must be called on the thread being configured. Returns the effective settings.
+SomWorkerStatus applySomWorkerSettings(const SomWorkerSettings& settings);
+// Reads back the calling thread's effective scheduling, nice level and affinity.
+SomWorkerStatus querySomWorkerStatus();
@@ -0,0 +1,76 @@
+// Accuracy checks for the fixed-point SOM backends against the float reference (compareSomBackends).
+// Needs openFrameworks and ofxSelfOrganizingMap: build it as the main.cpp of an empty oF project
+// with this addon (and its dependencies) added.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "ofxSomBackend.h"
+
+// Always evaluated, unlike assert(), so the checks still run (and still fail) under NDEBUG.
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+      std::exit(1); \
+    } \
+  } while (0)
+
+namespace {
+
+// Clustered audio-like features: a new centre every 500 instances, with some spread around it.
+std::vector<SomInstanceDataT> makeInstances(size_t count) {
+  std::mt19937 rng(3);
+  std::normal_distribution<double> spread(0.0, 0.08);
+  std::uniform_real_distribution<double> centres(0.2, 0.8);
+  std::vector<SomInstanceDataT> instances;
+  SomInstanceDataT centre { 0.5, 0.5, 0.5 };
+  for (size_t k = 0; k < count; ++k) {
+    if (k % 500 == 0) {
+      for (auto& c : centre) c = centres(rng);
+    }
+    SomInstanceDataT instance;
+    for (int z = 0; z < 3; ++z) instance[z] = std::clamp(centre[z] + spread(rng), 0.0, 1.0);
+    instances.push_back(instance);
+  }
+  return instances;
+}
+
+// At the palettes' usual learning rates (0.01-0.015) the fixed-point maps stay close to the float
+// map trained from the same weights: the quantization error may be at most 10% worse, and the mean
+// per-weight difference stays within a few 8-bit steps (16-bit) or the 8-bit rounding noise.
+void testFixedPointTracksFloat() {
+  const auto instances = makeInstances(5000);
+  for (int size : { 16, 32 }) {
+    const auto fixed16 = compareSomBackends(SomBackendType::Fixed16, size, size, 0.01f, instances);
+    CHECK(fixed16.candidateQuantizationError <= fixed16.referenceQuantizationError * 1.1f);
+    CHECK(fixed16.meanWeightDifference <= 0.02f);
+
+    const auto fixed8 = compareSomBackends(SomBackendType::Fixed8, size, size, 0.01f, instances);
+    CHECK(fixed8.candidateQuantizationError <= fixed8.referenceQuantizationError * 1.1f);
+    CHECK(fixed8.meanWeightDifference <= 0.08f);
+  }
+}
+
+void testFixedPointMapsStartApart() {
+  auto a = makeSomBackend(SomBackendType::Fixed16);
+  auto b = makeSomBackend(SomBackendType::Fixed16);
+  a->setup(8, 8, 0.01f, 100);
+  b->setup(8, 8, 0.01f, 100);
+  std::vector<float> weightsA, weightsB;
+  a->readWeights(weightsA);
+  b->readWeights(weightsB);
+  CHECK(weightsA != weightsB);
+}
+
+} // namespace
+
+int main() {
+  testFixedPointTracksFloat();
+  testFixedPointMapsStartApart();
+  std::printf("SomBackend: ok\n");
+  return 0;
+}
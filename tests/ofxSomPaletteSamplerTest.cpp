@@ -0,0 +1,92 @@
+// Known-texel checks for sampleBilinearMirrored. Needs openFrameworks' headers and library (for
+// ofFloatPixels and glm): build it as the main.cpp of an empty oF project with this addon added.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "ofxSomPaletteSampler.h"
+
+// Always evaluated, unlike assert(), so the checks still run (and still fail) under NDEBUG.
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+      std::exit(1); \
+    } \
+  } while (0)
+
+namespace {
+
+constexpr float tolerance = 1e-5f;
+
+// 2x2 field whose red channel is the texel's index, x + 2 * y.
+ofFloatPixels makeField() {
+  ofFloatPixels pixels;
+  pixels.allocate(2, 2, OF_IMAGE_COLOR);
+  for (int y = 0; y < 2; ++y) {
+    for (int x = 0; x < 2; ++x) {
+      float* c = pixels.getData() + (y * 2 + x) * 3;
+      c[0] = static_cast<float>(x + 2 * y);
+      c[1] = 0.5f;
+      c[2] = 0.0f;
+    }
+  }
+  return pixels;
+}
+
+float sampleRed(const ofFloatPixels& pixels, float u, float v) {
+  const glm::vec2 uv { u, v };
+  ofFloatColor color;
+  sampleBilinearMirrored(pixels, &uv, &color, 1);
+  return color.r;
+}
+
+void testTexelCentresAndBlend() {
+  const ofFloatPixels pixels = makeField();
+  CHECK(std::abs(sampleRed(pixels, 0.25f, 0.25f) - 0.0f) < tolerance);
+  CHECK(std::abs(sampleRed(pixels, 0.75f, 0.25f) - 1.0f) < tolerance);
+  CHECK(std::abs(sampleRed(pixels, 0.25f, 0.75f) - 2.0f) < tolerance);
+  CHECK(std::abs(sampleRed(pixels, 0.75f, 0.75f) - 3.0f) < tolerance);
+  CHECK(std::abs(sampleRed(pixels, 0.5f, 0.5f) - 1.5f) < tolerance);
+  // The edge texel's mirror is itself, so the border doesn't blend in the far side.
+  CHECK(std::abs(sampleRed(pixels, 0.0f, 0.25f) - 0.0f) < tolerance);
+}
+
+void testMirroredWrap() {
+  const ofFloatPixels pixels = makeField();
+  CHECK(std::abs(sampleRed(pixels, 1.25f, 0.25f) - 1.0f) < tolerance); // mirrors to 0.75
+  CHECK(std::abs(sampleRed(pixels, -0.25f, 0.25f) - 0.0f) < tolerance); // mirrors to 0.25
+  CHECK(std::abs(sampleRed(pixels, 2.25f, 0.25f) - 0.0f) < tolerance); // one full period on
+  CHECK(std::abs(sampleRed(pixels, 1000.25f, -999.25f) - 2.0f) < tolerance);
+}
+
+void testNonFiniteAndHugeUvs() {
+  const ofFloatPixels pixels = makeField();
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float inf = std::numeric_limits<float>::infinity();
+  CHECK(std::abs(sampleRed(pixels, nan, 0.75f) - 2.0f) < tolerance); // x falls back to texel 0
+  CHECK(std::abs(sampleRed(pixels, 0.75f, -inf) - 1.0f) < tolerance); // y falls back to texel 0
+  CHECK(std::abs(sampleRed(pixels, inf, nan) - 0.0f) < tolerance);
+
+  // Far outside the int range: any texel blend, but a finite colour and no out-of-range read.
+  const std::vector<glm::vec2> uvs { { 3.0e9f, -3.0e9f }, { 1.0e30f, 0.25f }, { -std::numeric_limits<float>::max(), 0.5f } };
+  std::vector<ofFloatColor> colors(uvs.size());
+  sampleBilinearMirrored(pixels, uvs.data(), colors.data(), uvs.size());
+  for (const auto& color : colors) {
+    CHECK(std::isfinite(color.r) && color.r >= 0.0f && color.r <= 3.0f);
+    CHECK(std::abs(color.g - 0.5f) < tolerance);
+  }
+}
+
+} // namespace
+
+int main() {
+  testTexelCentresAndBlend();
+  testMirroredWrap();
+  testNonFiniteAndHugeUvs();
+  std::printf("SomPaletteSampler: ok\n");
+  return 0;
+}
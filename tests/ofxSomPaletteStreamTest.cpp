@@ -0,0 +1,204 @@
+// Standalone loopback checks for the SomPaletteStream codec (no openFrameworks or sockets needed):
+//   g++ -std=c++17 -Isrc tests/ofxSomPaletteStreamTest.cpp src/ofxSomPaletteStream.cpp -o paletteStreamTest && ./paletteStreamTest
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "ofxSomPaletteStream.h"
+
+using namespace SomPaletteStream;
+
+// Always evaluated, unlike CHECK(), so the checks still run (and still fail) under NDEBUG.
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+      std::exit(1); \
+    } \
+  } while (0)
+
+namespace {
+
+constexpr uint16_t width = 16;
+constexpr uint16_t height = 16;
+constexpr size_t numSamples = static_cast<size_t>(width) * height * 3;
+constexpr float keyframeTolerance = 0.5f / 65535.0f + 1e-6f;
+// Half a delta step (1 << 6) plus the 16-bit rounding of the source.
+constexpr float deltaTolerance = 32.5f / 65535.0f + 1e-6f;
+
+struct Loopback {
+  explicit Loopback(int keyframeInterval, uint16_t sessionId = 1) : encoder { keyframeInterval, 6, sessionId } {}
+
+  // Sends one snapshot, dropping the packet at dropIndex; returns true if the decoder completed it.
+  bool send(const std::vector<float>& rgb, int dropIndex = -1) {
+    packets.clear();
+    encoder.encode(rgb.data(), width, height, palette, packets);
+    bool isComplete = false;
+    for (size_t i = 0; i < packets.size(); ++i) {
+      if (static_cast<int>(i) == dropIndex) continue;
+      if (decoder.decode(packets[i].data(), packets[i].size())) isComplete = true;
+    }
+    return isComplete;
+  }
+
+  float getMaxError(const std::vector<float>& rgb) const {
+    std::vector<float> out(numSamples);
+    decoder.getFloatField(out.data());
+    float maxError = 0.0f;
+    for (size_t i = 0; i < numSamples; ++i) maxError = std::max(maxError, std::abs(out[i] - rgb[i]));
+    return maxError;
+  }
+
+  Encoder encoder;
+  Decoder decoder;
+  std::array<uint8_t, paletteBytes> palette {};
+  std::vector<std::vector<uint8_t>> packets;
+};
+
+void testSmallChangesReconstruct() {
+  Loopback loopback { 30 };
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> step(-0.01f, 0.01f);
+  std::vector<float> rgb(numSamples, 0.5f);
+  for (int frame = 0; frame < 200; ++frame) {
+    for (auto& v : rgb) v = std::min(1.0f, std::max(0.0f, v + step(rng)));
+    CHECK(loopback.send(rgb));
+    // Deltas are closed loop, so the error stays within one quantization step rather than growing.
+    CHECK(loopback.getMaxError(rgb) <= deltaTolerance);
+  }
+  CHECK(loopback.decoder.getPacketsLost() == 0);
+  CHECK(loopback.decoder.getFramesCompleted() == 200);
+}
+
+void testLargeJumpTakesSeveralFrames() {
+  Loopback loopback { 1000 };
+  std::vector<float> rgb(numSamples, 0.0f);
+  CHECK(loopback.send(rgb)); // keyframe
+  CHECK(loopback.getMaxError(rgb) <= keyframeTolerance);
+
+  // Each delta moves a sample by at most 127 << 6 of 65535.
+  std::fill(rgb.begin(), rgb.end(), 1.0f);
+  const float maxStep = 127.0f * 64.0f / 65535.0f;
+  float previousError = 1.0f;
+  int frames = 0;
+  while (loopback.getMaxError(rgb) > deltaTolerance) {
+    CHECK(loopback.send(rgb));
+    const float error = loopback.getMaxError(rgb);
+    CHECK(error >= previousError - maxStep - 1e-6f);
+    previousError = error;
+    CHECK(++frames <= 10);
+  }
+  CHECK(frames == static_cast<int>(std::ceil(1.0f / maxStep)));
+}
+
+void testLossHoldsUntilKeyframe() {
+  constexpr int keyframeInterval = 10;
+  Loopback loopback { keyframeInterval };
+  std::vector<float> rgb(numSamples, 0.25f);
+  CHECK(loopback.send(rgb)); // keyframe
+  for (int frame = 1; frame < 4; ++frame) CHECK(loopback.send(rgb));
+
+  std::vector<float> held(numSamples);
+  loopback.decoder.getFloatField(held.data());
+
+  // Losing part of a delta leaves the decoder on its last good frame...
+  std::fill(rgb.begin(), rgb.end(), 0.5f);
+  CHECK(!loopback.send(rgb, 0));
+  CHECK(loopback.decoder.getPacketsLost() == 0); // not detected until the next packet arrives
+  for (int frame = 5; frame < keyframeInterval; ++frame) {
+    CHECK(!loopback.send(rgb));
+    CHECK(loopback.getMaxError(held) == 0.0f);
+  }
+  CHECK(loopback.decoder.getPacketsLost() == 1);
+  CHECK(loopback.decoder.getFramesDropped() > 0);
+
+  // ...until the next keyframe restores it exactly.
+  CHECK(loopback.send(rgb));
+  CHECK(loopback.getMaxError(rgb) <= keyframeTolerance);
+}
+
+void put16(std::vector<uint8_t>& packet, size_t at, uint16_t v) {
+  packet[at] = static_cast<uint8_t>(v);
+  packet[at + 1] = static_cast<uint8_t>(v >> 8);
+}
+
+void put32(std::vector<uint8_t>& packet, size_t at, uint32_t v) {
+  for (int i = 0; i < 4; ++i) packet[at + i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+void testSenderRestartResyncs() {
+  Loopback loopback { 10 };
+  std::vector<float> rgb(numSamples, 0.25f);
+  for (int frame = 0; frame < 20; ++frame) CHECK(loopback.send(rgb));
+
+  // A restarted sender counts frames and sequence numbers from zero again under a new session id.
+  loopback.encoder = Encoder { 10, 6, 2 };
+  std::fill(rgb.begin(), rgb.end(), 0.75f);
+  CHECK(loopback.send(rgb)); // its first packet is a keyframe
+  CHECK(loopback.getMaxError(rgb) <= keyframeTolerance);
+  for (int frame = 1; frame < 20; ++frame) {
+    for (auto& v : rgb) v = std::max(0.0f, v - 0.005f);
+    CHECK(loopback.send(rgb));
+    CHECK(loopback.getMaxError(rgb) <= deltaTolerance);
+  }
+
+  // Late deltas from the old session don't disturb the new one (only a keyframe switches sessions).
+  Loopback old { 10, 1 };
+  old.encoder.encode(rgb.data(), width, height, old.palette, old.packets);
+  old.packets.clear();
+  old.encoder.encode(rgb.data(), width, height, old.palette, old.packets);
+  for (const auto& packet : old.packets) CHECK(!loopback.decoder.decode(packet.data(), packet.size()));
+  CHECK(loopback.getMaxError(rgb) <= deltaTolerance);
+}
+
+void testRejectsMalformedChunks() {
+  Loopback loopback { 30 };
+  std::vector<float> rgb(numSamples, 0.5f);
+  loopback.encoder.encode(rgb.data(), width, height, loopback.palette, loopback.packets);
+  CHECK(loopback.packets.size() == 2);
+  CHECK(!loopback.decoder.decode(loopback.packets[0].data(), loopback.packets[0].size()));
+
+  // A chunk of the frame being staged that claims a much larger frame: self-consistent on its own,
+  // but it would write far past the 16x16 staging buffer.
+  std::vector<uint8_t> oversized = loopback.packets[1];
+  constexpr uint16_t bigSide = 200;
+  constexpr size_t samplesPerChunk = maxPayloadBytes / 2;
+  constexpr size_t bigSamples = static_cast<size_t>(bigSide) * bigSide * 3;
+  constexpr uint16_t chunkIndex = 50000 / samplesPerChunk;
+  oversized.resize(headerBytes + samplesPerChunk * 2, 0xff);
+  put16(oversized, 8, chunkIndex);
+  put16(oversized, 10, static_cast<uint16_t>((bigSamples + samplesPerChunk - 1) / samplesPerChunk));
+  put16(oversized, 12, bigSide);
+  put16(oversized, 14, bigSide);
+  put16(oversized, 16, static_cast<uint16_t>(samplesPerChunk));
+  put32(oversized, 32, static_cast<uint32_t>(chunkIndex * samplesPerChunk));
+  CHECK(!loopback.decoder.decode(oversized.data(), oversized.size()));
+
+  // Offsets that don't follow the encoder's split, and shifts wider than a sample.
+  std::vector<uint8_t> shifted = loopback.packets[1];
+  put32(shifted, 32, 1);
+  CHECK(!loopback.decoder.decode(shifted.data(), shifted.size()));
+  std::vector<uint8_t> wideShift = loopback.packets[1];
+  wideShift[6] = 9;
+  PacketHeader header;
+  CHECK(!readHeader(wideShift.data(), wideShift.size(), header));
+
+  // The genuine chunk still completes the frame.
+  CHECK(loopback.decoder.decode(loopback.packets[1].data(), loopback.packets[1].size()));
+  CHECK(loopback.getMaxError(rgb) <= keyframeTolerance);
+}
+
+} // namespace
+
+int main() {
+  testSmallChangesReconstruct();
+  testLargeJumpTakesSeveralFrames();
+  testLossHoldsUntilKeyframe();
+  testSenderRestartResyncs();
+  testRejectsMalformedChunks();
+  std::printf("SomPaletteStream: ok\n");
+  return 0;
+}
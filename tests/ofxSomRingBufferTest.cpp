@@ -0,0 +1,62 @@
+// Standalone checks for SomRingBuffer (header-only, no openFrameworks needed):
+//   g++ -std=c++17 -Isrc tests/ofxSomRingBufferTest.cpp -o ringBufferTest && ./ringBufferTest
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "ofxSomRingBuffer.h"
+
+// Always evaluated, unlike CHECK(), so the checks still run (and still fail) under NDEBUG.
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+      std::exit(1); \
+    } \
+  } while (0)
+
+namespace {
+
+void testClearThenPushThenPop() {
+  SomRingBuffer<int> ring(4);
+  int value = 0;
+
+  // Prime the consumer's cached write index, then queue more behind it and clear.
+  CHECK(ring.push(1));
+  CHECK(ring.pop(value) && value == 1);
+  CHECK(ring.push(2));
+  CHECK(ring.push(3));
+  ring.clear();
+  CHECK(ring.sizeApprox() == 0);
+  CHECK(!ring.pop(value));
+
+  CHECK(ring.push(4));
+  CHECK(ring.pop(value) && value == 4);
+  CHECK(!ring.pop(value));
+  CHECK(ring.sizeApprox() == 0);
+
+  // The producer still sees the full capacity.
+  for (size_t i = 0; i < ring.getCapacity(); ++i) CHECK(ring.push(static_cast<int>(i)));
+  CHECK(!ring.push(99));
+  for (size_t i = 0; i < ring.getCapacity(); ++i) CHECK(ring.pop(value) && value == static_cast<int>(i));
+}
+
+void testWrapAround() {
+  SomRingBuffer<int> ring(2);
+  int value = 0;
+  for (int i = 0; i < 1000; ++i) {
+    CHECK(ring.push(i));
+    if (i % 7 == 0) ring.clear();
+    else CHECK(ring.pop(value) && value == i);
+  }
+  CHECK(ring.sizeApprox() == 0);
+}
+
+} // namespace
+
+int main() {
+  testClearThenPushThenPop();
+  testWrapAround();
+  std::printf("SomRingBuffer: ok\n");
+  return 0;
+}